@@ -0,0 +1,109 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_CLEARANCE_COST_H
+#define PATH_PLANNING_GRAPH_SEARCH_CLEARANCE_COST_H
+
+#include <vector>
+#include <cstdint>
+
+#include <path_planning/utils/graph_utils.h>
+
+
+enum ClearanceDecay
+{
+    CLEARANCE_LINEAR,       // Cost falls linearly to zero at the influence radius.
+    CLEARANCE_EXPONENTIAL   // Cost falls exponentially, and is cut to zero at the influence radius.
+};
+
+
+struct ClearanceProfile
+{
+    ClearanceProfile() :
+        decay(CLEARANCE_LINEAR),
+        influence_radius(0.5),
+        decay_length(0.1),
+        weight(2)
+    {
+    };
+
+    ClearanceDecay decay;    // How the cost falls with distance from the collision radius.
+    float influence_radius;  // Distance past the collision radius where the cost reaches zero, in meters.
+    float decay_length;      // Distance over which the exponential cost falls by a factor of e, in meters.
+    float weight;            // Extra cost per cell of travel at the highest clearance cost.
+};
+
+
+struct ClearanceLayer
+{
+    ClearanceLayer() :
+        penalty(),
+        dt_version(0),
+        collision_radius(0)
+    {
+    };
+
+    std::vector<uint8_t> costs;   // Clearance cost of each cell, from 0 (clear) to 255 (at the collision radius).
+    float penalty[256];           // Extra cost per cell of travel for each cost value.
+    uint32_t dt_version;          // The graph.dt_version the costs were built from.
+    float collision_radius;       // The collision radius the costs were built with.
+    ClearanceProfile profile;     // The profile the costs were built with.
+};
+
+
+struct ClearanceResult
+{
+    std::vector<Cell> path;  // The path from the start to the goal, or an empty path.
+    float cost;              // The total cost of the path, in cells.
+    float length;            // The length of the path, in cells.
+    float clearance_cost;    // The part of the cost paid for clearance, cost - length.
+};
+
+
+/**
+ * Builds the clearance cost layer from the distance transform, unless it was
+ * already built from the current distance transform with the same settings.
+ *
+ * Warning: A distance transform must be computed for this function to work.
+ * @param  graph    The graph to build the layer for.
+ * @param  layer    The layer to update.
+ * @param  profile  How the cost falls with distance from obstacles.
+ * @return  True if the layer was rebuilt.
+ */
+bool updateClearanceLayer(const GridGraph& graph, ClearanceLayer& layer,
+                          const ClearanceProfile& profile = ClearanceProfile());
+
+/**
+ * Checks whether the layer was built from the graph's current distance
+ * transform and collision radius with this profile.
+ */
+bool isClearanceLayerCurrent(const GridGraph& graph, const ClearanceLayer& layer, const ClearanceProfile& profile);
+
+/**
+ * Returns the layer cached in graph.clearance, building it first if the
+ * distance transform, collision radius or profile changed since it was last
+ * built.
+ *
+ * Warning: A distance transform must be computed for this function to work.
+ * @param  graph    The graph to build the layer for.
+ * @param  profile  How the cost falls with distance from obstacles.
+ */
+const ClearanceLayer& getClearanceLayer(GridGraph& graph, const ClearanceProfile& profile = ClearanceProfile());
+
+/**
+ * Runs A-star where each step costs its length times one plus the clearance
+ * penalty of the cell it enters. The octile distance heuristic stays
+ * admissible since penalties are never negative.
+ * @param  graph  The graph to search.
+ * @param  layer  The clearance layer, from getClearanceLayer() or updateClearanceLayer().
+ * @param  start  The start cell.
+ * @param  goal   The goal cell.
+ */
+ClearanceResult clearanceAStarSearch(GridGraph& graph, const ClearanceLayer& layer,
+                                     const Cell& start, const Cell& goal);
+
+/**
+ * Runs the same search, keeping the visited cells and search status in the
+ * given scratch so the graph is only read.
+ */
+ClearanceResult clearanceAStarSearch(const GridGraph& graph, SearchScratch& scratch, const ClearanceLayer& layer,
+                                     const Cell& start, const Cell& goal);
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_CLEARANCE_COST_H
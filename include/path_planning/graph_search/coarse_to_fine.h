@@ -0,0 +1,64 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_COARSE_TO_FINE_H
+#define PATH_PLANNING_GRAPH_SEARCH_COARSE_TO_FINE_H
+
+#include <vector>
+
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/graph_search/graph_search.h>
+#include <path_planning/graph_search/scratch_search.h>
+
+
+struct MapLevel
+{
+    int width, height;              // Width and height of the level in cells.
+    int scale;                      // Number of map cells per level cell along each axis.
+    std::vector<uint8_t> blocked;   // 1 if any map cell inside the level cell is occupied.
+};
+
+
+struct MapPyramid
+{
+    std::vector<MapLevel> levels;   // Level 0 has the map resolution. Each level halves the last.
+    int8_t threshold;               // The occupancy threshold the pyramid was built with.
+};
+
+
+/**
+ * Builds a conservative resolution pyramid over the occupancy in
+ * graph.cell_odds. A coarse cell is blocked if any of the map cells it covers
+ * are occupied. This only needs to be done once per map.
+ * @param  graph     The loaded graph.
+ * @param  pyramid   The pyramid to populate.
+ * @param  min_size  Stop adding levels once a level is this small along either axis.
+ */
+void buildMapPyramid(const GridGraph& graph, MapPyramid& pyramid, int min_size = 8);
+
+/**
+ * Returns the pyramid cached in graph.pyramid, building it first if the map
+ * was loaded or its threshold changed since it was last built.
+ * @param  graph  The loaded graph.
+ */
+const MapPyramid& getMapPyramid(GridGraph& graph);
+
+/**
+ * Plans a path by first finding a path on the coarsest pyramid level where the
+ * start and goal are connected, then running the given search restricted to a
+ * corridor around the coarse path using graph.search_mask. If the restricted
+ * search fails, the corridor is widened until it covers the whole map.
+ * @param  graph            The graph to search.
+ * @param  pyramid          The pyramid built from the graph.
+ * @param  start            The start cell.
+ * @param  goal             The goal cell.
+ * @param  corridor_radius  The initial corridor half width, in coarse cells.
+ * @param  search           The search to run on the full resolution map. It
+ *                          must treat cells outside graph.search_mask as in
+ *                          collision, as checkCollisionFast() does. Pass
+ *                          aStarSearch to use your own A-star.
+ * @return  The path found by the search, or an empty path.
+ */
+std::vector<Cell> coarseToFineSearch(GridGraph& graph, const MapPyramid& pyramid,
+                                     const Cell& start, const Cell& goal,
+                                     int corridor_radius = 1,
+                                     SearchFunction search = scratchAStarSearch);
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_COARSE_TO_FINE_H
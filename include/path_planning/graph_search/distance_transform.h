@@ -11,4 +11,15 @@ void distanceTransformManhattan(GridGraph& graph);
 std::vector<float> distanceTransformEuclidean1D(std::vector<float>& init_dt);
 void distanceTransformEuclidean2D(GridGraph& graph);
 
+/**
+ * Computes the exact Euclidean distance transform using only integer squared
+ * cell distances (Meijster et al.). The result is stored in
+ * graph.obstacle_sq_distances, which checkCollisionFast() then uses instead of
+ * graph.obstacle_distances. The float distances are freed, so this takes half
+ * the memory of a float distance transform. Also updates
+ * graph.collision_sq_threshold.
+ * @param  graph  The graph to compute the distance transform for.
+ */
+void distanceTransformSquared(GridGraph& graph);
+
 #endif  // PATH_PLANNING_GRAPH_SEARCH_DISTANCE_TRANSFORM_H
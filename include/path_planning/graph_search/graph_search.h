@@ -6,6 +6,9 @@
 #include <path_planning/utils/graph_utils.h>
 
 
+// The signature shared by the single goal search functions.
+typedef std::vector<Cell> (*SearchFunction)(GridGraph& graph, const Cell& start, const Cell& goal);
+
 std::vector<Cell> depthFirstSearch(GridGraph& graph, const Cell& start, const Cell& goal);
 std::vector<Cell> breadthFirstSearch(GridGraph& graph, const Cell& start, const Cell& goal);
 std::vector<Cell> iterativeDeepeningSearch(GridGraph& graph, const Cell& start, const Cell& goal);
@@ -0,0 +1,108 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_LATTICE_PLANNER_H
+#define PATH_PLANNING_GRAPH_SEARCH_LATTICE_PLANNER_H
+
+#include <array>
+#include <vector>
+
+#include <path_planning/utils/graph_utils.h>
+
+
+struct LatticeState
+{
+    int i, j;     // Row and column index of the cell in the graph.
+    int heading;  // Index of the discretized heading, in [0, num_headings).
+};
+
+
+struct MotionPrimitive
+{
+    int di, dj;                         // Cell offset from the start to the end of the motion.
+    int end_heading;                    // Heading at the end of the motion.
+    float cost;                         // Cost of the motion, in cells.
+    std::vector<LatticeState> samples;  // Offsets and headings swept by the motion, ending at the end state.
+};
+
+
+struct Lattice
+{
+    int num_headings;                                           // Number of discretized headings.
+    std::vector<std::vector<std::array<int, 2> > > masks;       // Cell offsets covered by the footprint at each heading.
+    std::vector<std::vector<MotionPrimitive> > primitives;      // Motions available from each heading.
+    float free_sq_dist;      // Obstacles further than this (squared, in cells) can't touch any mask.
+    float blocked_sq_dist;   // Obstacles at or within this (squared, in cells) are inside every mask.
+    int extent;              // Largest offset along either axis in any mask.
+};
+
+
+/**
+ * Makes a rectangular footprint centered on the robot, facing along x.
+ * @param  length  Length of the robot along its heading, in meters.
+ * @param  width   Width of the robot, in meters.
+ * @return  The polygon vertices in the robot frame, counter clockwise.
+ */
+std::vector<std::array<float, 2> > makeRectangleFootprint(float length, float width);
+
+/**
+ * Precomputes the footprint masks and motion primitives of the lattice.
+ * @param  graph         The graph the lattice will be used on. Only the cell size is used.
+ * @param  footprint     The footprint polygon in the robot frame, in meters.
+ * @param  lattice       The lattice to populate.
+ * @param  num_headings  The number of discretized headings.
+ * @param  step_length   The length of the long motion primitives, in cells.
+ * @param  turn_cost     The cost of turning in place by one heading, in cells.
+ */
+void initLattice(const GridGraph& graph, const std::vector<std::array<float, 2> >& footprint,
+                 Lattice& lattice, int num_headings = 16, float step_length = 4,
+                 float turn_cost = 1);
+
+/**
+ * Checks whether the footprint at the given state overlaps an obstacle or the
+ * edge of the map. The distance transform is used to accept or reject most
+ * states, so the full mask is only checked close to obstacles. Without a
+ * distance transform, the full mask is always checked.
+ * @param  state    The state to check.
+ * @param  graph    The graph the state belongs to.
+ * @param  lattice  The precomputed lattice.
+ */
+bool checkFootprintCollision(const LatticeState& state, const GridGraph& graph, const Lattice& lattice);
+
+/**
+ * Runs A-star over the (i, j, heading) lattice. The goal is reached in any
+ * heading.
+ * @param  graph    The graph to search.
+ * @param  lattice  The precomputed lattice.
+ * @param  start    The start state.
+ * @param  goal     The goal cell.
+ * @return  The states along the path, including every swept sample, or an empty
+ *          path if there is none or the node memory cap in the graph is reached.
+ *          graph.search_status tells the two apart.
+ */
+std::vector<LatticeState> latticeSearch(GridGraph& graph, const Lattice& lattice,
+                                        const LatticeState& start, const Cell& goal);
+
+/**
+ * Runs the same search, keeping the visited cells and search status in the
+ * given scratch so the graph is only read.
+ */
+std::vector<LatticeState> latticeSearch(const GridGraph& graph, SearchScratch& scratch, const Lattice& lattice,
+                                        const LatticeState& start, const Cell& goal);
+
+/**
+ * Checks that the lattice path goes from the start to the goal through
+ * adjacent cells, with the footprint clear of obstacles at every state.
+ */
+bool isValidLatticePath(const std::vector<LatticeState>& path, const LatticeState& start, const Cell& goal,
+                        const GridGraph& graph, const Lattice& lattice);
+
+/**
+ * Converts a lattice path to a list of cells, for visualization.
+ */
+std::vector<Cell> latticePathToCells(const std::vector<LatticeState>& path);
+
+/**
+ * Converts a lattice path to a list of poses [x, y, theta] in meters and radians.
+ */
+std::vector<std::array<float, 3> > latticePathToPoses(const std::vector<LatticeState>& path,
+                                                      const Lattice& lattice, const GridGraph& graph);
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_LATTICE_PLANNER_H
@@ -0,0 +1,130 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_MULTI_AGENT_H
+#define PATH_PLANNING_GRAPH_SEARCH_MULTI_AGENT_H
+
+#include <vector>
+#include <cstdint>
+
+#include <path_planning/utils/graph_utils.h>
+
+
+struct AgentQuery
+{
+    Cell start, goal;  // Start and goal cells of one robot.
+};
+
+
+#define RESERVATION_BLOCK_BITS 3  // Reservations are stored in square blocks of 2^RESERVATION_BLOCK_BITS cells.
+
+
+/**
+ * Space-time reservations of the robots planned so far. The map is split into
+ * 8x8 cell blocks, and the reserved cells of each (time, block) pair are kept
+ * as a 64 bit mask in an open addressing hash table keyed by the pair. A robot
+ * reserves a disk of cells, which only touches a few blocks.
+ */
+struct ReservationTable
+{
+    std::vector<uint64_t> block_keys;  // Reserved (time, block) pairs. Empty slots are ~0.
+    std::vector<uint64_t> block_bits;  // Reserved cells of the block in each slot, one bit per cell.
+    std::vector<uint64_t> edge_keys;   // Reserved (time, cell, direction) moves, when separation is 0.
+    size_t num_blocks, num_edges;      // Number of keys in each set.
+    std::vector<int> hold_times;       // Time each cell is reserved from onwards, by robots at their goals. Empty
+                                       // until a cell is held.
+    std::vector<int> wait_counts;      // Number of robots waiting at their start near each cell, reserved at all
+                                       // times. Empty until a robot waits.
+    int width;                         // Width of the map in cells.
+    int blocks_wide;                   // Width of the map in blocks.
+    int horizon;                       // Latest time step with a reservation.
+    int separation;                    // Cells within this distance of a robot are reserved too.
+};
+
+
+struct MultiAgentOptions
+{
+    MultiAgentOptions() :
+        max_time(-1),
+        separation(-1),
+        time_budget_ms(500)
+    {
+    };
+
+    int max_time;          // Longest allowed path, in time steps. -1 uses twice the map width plus height.
+    int separation;        // Robot centers must be further apart than this, in cells. -1 uses twice graph.collision_radius.
+    float time_budget_ms;  // Robots not planned within this time get no path.
+};
+
+
+struct MultiAgentResult
+{
+    std::vector<std::vector<Cell> > paths;  // Cell of each robot at each time step. Empty if not planned.
+    int num_planned;                        // Number of robots with a path.
+    bool over_budget;                       // Whether planning stopped because of the time budget.
+    bool memory_capped;                     // Whether a robot's search stopped at the node memory cap.
+};
+
+
+/**
+ * Clears the table and sets the separation between robots.
+ */
+void initReservationTable(ReservationTable& table, int separation, const GridGraph& graph);
+
+/**
+ * Reserves the cells within the separation distance of the cell at time t.
+ */
+void reserveCell(ReservationTable& table, int t, int idx, const GridGraph& graph);
+
+/**
+ * Reserves the cells within the separation distance of the cell from time t
+ * onwards.
+ */
+void holdCell(ReservationTable& table, int t, int idx, const GridGraph& graph);
+
+/**
+ * Reserves the cells within the separation distance of a robot's start at all
+ * times, while the robot waits there.
+ */
+void addWaitingRobot(ReservationTable& table, int idx, const GridGraph& graph);
+
+/**
+ * Removes a reservation added by addWaitingRobot(), once the robot has a path.
+ */
+void removeWaitingRobot(ReservationTable& table, int idx, const GridGraph& graph);
+
+/**
+ * Checks whether the cell is reserved at time t.
+ */
+bool isCellReserved(const ReservationTable& table, int t, int idx);
+
+/**
+ * Plans a path for one robot in (cell, time) that avoids the reservations in
+ * the table. The search is 4-connected with a wait action, and every step
+ * takes one time step. Robots stay at their goal once they arrive, so the goal
+ * must stay free after the arrival time.
+ * @param  graph     The shared graph. The distance transform must be computed.
+ * @param  table     The reservations of higher priority robots.
+ * @param  query     The start and goal of the robot.
+ * @param  max_time  The longest allowed path, in time steps.
+ * @param  deadline  Stop searching at this time, from traceTimeMicro().
+ * @param  status    If not null, set to SEARCH_MEMORY_CAP if the search stopped
+ *                   at the node memory cap, and SEARCH_DONE otherwise.
+ * @return  The cell of the robot at each time step, or an empty path.
+ */
+std::vector<Cell> spaceTimeSearch(const GridGraph& graph, const ReservationTable& table,
+                                  const AgentQuery& query, int max_time, uint64_t deadline,
+                                  SearchStatus* status = nullptr);
+
+/**
+ * Plans paths for several robots in priority order. Each robot is planned
+ * against the reservations of the robots before it, then its own path is
+ * reserved. All the robots share the graph and its distance transform. Robots
+ * wait at their start until they have a path, so the starts of the robots not
+ * planned yet are reserved too, and robots which get no path, or are skipped
+ * at the time budget, never block a path that was planned.
+ * @param  graph    The shared graph. The distance transform must be computed.
+ * @param  agents   The robots, highest priority first.
+ * @param  options  Planning settings.
+ */
+MultiAgentResult prioritizedPlan(const GridGraph& graph, const std::vector<AgentQuery>& agents,
+                                 const MultiAgentOptions& options = MultiAgentOptions());
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_MULTI_AGENT_H
@@ -0,0 +1,44 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_MULTI_GOAL_SEARCH_H
+#define PATH_PLANNING_GRAPH_SEARCH_MULTI_GOAL_SEARCH_H
+
+#include <vector>
+
+#include <path_planning/utils/graph_utils.h>
+
+
+struct GoalResult
+{
+    Cell goal;               // The goal that was reached.
+    float cost;              // The path cost to the goal, in cells.
+    std::vector<Cell> path;  // The path from the start to the goal.
+};
+
+
+/**
+ * Finds the k goals with the lowest path cost from the start using a single
+ * Dijkstra search that stops once k goals have been reached. The search is
+ * 8-connected, diagonal moves need both side cells free, and it uses
+ * checkCollisionFast(), so the distance transform must be computed first.
+ * @param  graph  The graph to search.
+ * @param  start  The start cell.
+ * @param  goals  The candidate goal cells.
+ * @param  k      The maximum number of goals to return.
+ * @return  Up to k reachable goals, sorted by increasing path cost. If the node
+ *          memory cap in the graph is reached, the goals found so far, and
+ *          graph.search_status is set to SEARCH_MEMORY_CAP.
+ */
+std::vector<GoalResult> nearestGoalsSearch(GridGraph& graph, const Cell& start,
+                                           const std::vector<Cell>& goals, int k);
+
+/**
+ * Finds the path to the reachable goal with the lowest path cost.
+ * @param  graph         The graph to search.
+ * @param  start         The start cell.
+ * @param  goals         The candidate goal cells.
+ * @param  reached_goal  Set to the goal that was reached, if any.
+ * @return  The path to the nearest goal, or an empty path if none is reachable.
+ */
+std::vector<Cell> nearestGoalSearch(GridGraph& graph, const Cell& start,
+                                    const std::vector<Cell>& goals, Cell& reached_goal);
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_MULTI_GOAL_SEARCH_H
@@ -0,0 +1,162 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_NODE_STORE_H
+#define PATH_PLANNING_GRAPH_SEARCH_NODE_STORE_H
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <path_planning/utils/graph_utils.h>
+
+#define NODE_BLOCK_BITS 12  // Sparse node records are allocated in blocks of 2^NODE_BLOCK_BITS.
+
+
+struct NodeRecord
+{
+    float cost;   // The cost from the start. HIGH if the node has not been reached.
+    int parent;   // The key of the parent node, -1 if there is none.
+    int data;     // Extra data the search needs, like the motion used to reach the node.
+    bool closed;  // Whether the node has been expanded.
+};
+
+
+/**
+ * Per search node data, keyed by an integer such as cellToIdx(). The dense
+ * backend keeps a record for every possible key. The sparse backend keeps an
+ * open addressing hash table of the keys that have been reached, pointing into
+ * a pooled arena of records, and stops adding nodes at a memory cap.
+ */
+struct NodeStore
+{
+    NodeStorage storage;         // NODES_DENSE or NODES_SPARSE, after initNodeStore().
+    size_t memory_cap;           // The most memory the node data may use, in bytes.
+    bool exhausted;              // Set when a node could not be added because of the memory cap.
+
+    std::vector<NodeRecord> dense;                     // Dense backend: one record per key.
+
+    std::vector<int64_t> keys;                         // Sparse backend: key in each hash slot, -1 if empty.
+    std::vector<int32_t> slots;                        // Sparse backend: arena index of the record in each slot.
+    std::vector<std::unique_ptr<NodeRecord[]> > blocks;  // Sparse backend: arena of node records.
+    int32_t num_nodes;                                 // Sparse backend: number of records in use.
+    int hash_bits;                                     // Sparse backend: log2 of the number of hash slots.
+};
+
+
+/**
+ * Estimates how many nodes a search from start to goal will touch, from the
+ * area of a disk around the straight line between them.
+ */
+int64_t estimateSearchNodes(const GridGraph& graph, const Cell& start, const Cell& goal);
+
+/**
+ * Prepares the store for a new search. With NODES_AUTO, the dense backend is
+ * used when the expected nodes are a large part of all the keys and the dense
+ * records fit within the memory cap. Otherwise the sparse backend is used.
+ * NODES_DENSE also falls back to sparse if the dense records would go over
+ * the memory cap.
+ * @param  store           The store to initialize.
+ * @param  num_keys        The number of possible keys. Keys are in [0, num_keys).
+ * @param  expected_nodes  The number of nodes the search is expected to touch.
+ * @param  storage         NODES_AUTO, NODES_DENSE or NODES_SPARSE.
+ * @param  memory_cap      The most memory the node data may use, in bytes.
+ */
+void initNodeStore(NodeStore& store, int64_t num_keys, int64_t expected_nodes,
+                   NodeStorage storage, size_t memory_cap);
+
+/**
+ * Prepares the store for a search on the graph, using the storage settings in
+ * graph.node_storage and graph.node_memory_cap.
+ */
+void initNodeStore(NodeStore& store, const GridGraph& graph, int64_t num_keys, int64_t expected_nodes);
+
+/**
+ * Grows the sparse hash table. Called by getNode().
+ * @return  False if the larger table would go over the memory cap.
+ */
+bool growNodeStore(NodeStore& store);
+
+
+static inline size_t hashNodeKey(int64_t key, int bits)
+{
+    return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> (64 - bits));
+}
+
+static inline NodeRecord* arenaNode(NodeStore& store, int32_t arena_idx)
+{
+    return &store.blocks[arena_idx >> NODE_BLOCK_BITS][arena_idx & ((1 << NODE_BLOCK_BITS) - 1)];
+}
+
+
+/**
+ * Finds the node with the given key.
+ * @return  The node, or nullptr if it has not been added. With the dense
+ *          backend every node exists, and unreached nodes have a cost of HIGH.
+ */
+static inline NodeRecord* findNode(NodeStore& store, int64_t key)
+{
+    if (store.storage == NODES_DENSE) return &store.dense[key];
+
+    size_t mask = (size_t(1) << store.hash_bits) - 1;
+    for (size_t slot = hashNodeKey(key, store.hash_bits); ; slot = (slot + 1) & mask)
+    {
+        if (store.keys[slot] == key) return arenaNode(store, store.slots[slot]);
+        if (store.keys[slot] < 0) return nullptr;
+    }
+}
+
+
+/**
+ * Finds the node with the given key, adding it if needed. New nodes have a
+ * cost of HIGH, no parent and are not closed. Pointers stay valid until the
+ * store is initialized again.
+ * @return  The node, or nullptr if adding it would go over the memory cap. In
+ *          that case store.exhausted is set and the search should stop. Nodes
+ *          already in the store are always found.
+ */
+static inline NodeRecord* getNode(NodeStore& store, int64_t key)
+{
+    if (store.storage == NODES_DENSE) return &store.dense[key];
+
+    size_t mask = (size_t(1) << store.hash_bits) - 1;
+    size_t slot = hashNodeKey(key, store.hash_bits);
+    for (; store.keys[slot] >= 0; slot = (slot + 1) & mask)
+    {
+        if (store.keys[slot] == key) return arenaNode(store, store.slots[slot]);
+    }
+
+    // The key is new. Keep the table at most half full so probe sequences
+    // stay short, and find the empty slot again if it grew.
+    if (2 * (store.num_nodes + 1) > (int64_t(1) << store.hash_bits))
+    {
+        if (!growNodeStore(store))
+        {
+            store.exhausted = true;
+            return nullptr;
+        }
+        mask = (size_t(1) << store.hash_bits) - 1;
+        slot = hashNodeKey(key, store.hash_bits);
+        while (store.keys[slot] >= 0) slot = (slot + 1) & mask;
+    }
+
+    // Take the next record from the arena, adding a block if needed.
+    if (size_t(store.num_nodes >> NODE_BLOCK_BITS) >= store.blocks.size())
+    {
+        size_t used = store.keys.size() * (sizeof(int64_t) + sizeof(int32_t)) +
+                      (store.blocks.size() + 1) * (sizeof(NodeRecord) << NODE_BLOCK_BITS);
+        if (used > store.memory_cap)
+        {
+            store.exhausted = true;
+            return nullptr;
+        }
+        store.blocks.emplace_back(new NodeRecord[1 << NODE_BLOCK_BITS]);
+    }
+
+    int32_t arena_idx = store.num_nodes++;
+    store.keys[slot] = key;
+    store.slots[slot] = arena_idx;
+
+    NodeRecord* node = arenaNode(store, arena_idx);
+    *node = {HIGH, -1, 0, false};
+    return node;
+}
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_NODE_STORE_H
@@ -0,0 +1,138 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_PLANNER_H
+#define PATH_PLANNING_GRAPH_SEARCH_PLANNER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/utils/query_trace.h>
+#include <path_planning/graph_search/clearance_cost.h>
+
+
+struct PlannerOptions
+{
+    PlannerOptions() :
+        footprint_length(2 * ROBOT_RADIUS),
+        footprint_width(2 * ROBOT_RADIUS),
+        portfolio({"astar", "bfs"})
+    {
+    };
+
+    float footprint_length, footprint_width;  // Rectangular footprint for the lattice planner, in meters.
+    ClearanceProfile clearance;               // Clearance cost profile for the clearance planner.
+    std::vector<std::string> portfolio;       // Planners run at once by the portfolio planner.
+    std::string portfolio_stats;              // File of portfolio win counts per map. Empty to not keep any.
+    std::string roadmap_file;                 // Where the roadmap planner loads and saves its roadmap. Empty to not save it.
+};
+
+
+/**
+ * What planPath() found out about a query besides the path.
+ */
+struct PlanSummary
+{
+    PlanSummary() :
+        winner_us(0),
+        clearance_cost(0)
+    {
+    };
+
+    std::string winner;    // The planner whose path the portfolio kept. Empty for other planners.
+    uint64_t winner_us;    // Time the portfolio took to find the winning path, in microseconds.
+    float clearance_cost;  // Part of the castar path cost added for passing near obstacles. 0 for other planners.
+};
+
+
+/**
+ * Checks whether the name is a planning algorithm known to planPath().
+ */
+bool isValidPlanner(const std::string& algo);
+
+/**
+ * Checks whether the planner can run on a graph shared with other searches,
+ * through the planPath() overload which takes a scratch. The searches in
+ * graph_search.h keep their node data in the graph, so on a shared graph
+ * "bfs" and "astar" run the searches in scratch_search.h instead, and "dfs"
+ * and "c2f" can't run at all.
+ */
+bool isSharedGraphPlanner(const std::string& algo);
+
+/**
+ * Checks whether the planner can run in a portfolio. The portfolio keeps the
+ * first path found, so it only runs planners which find comparable paths:
+ * shortest paths on the 8-connected grid, clear of the collision radius, by
+ * steps for "bfs" and by length for "astar", run on a shared graph.
+ */
+bool isPortfolioPlanner(const std::string& algo);
+
+/**
+ * Runs the distance transform with the given name ("float" or "int"). The name
+ * "none" is also accepted and does nothing.
+ * @return  False if the name is not valid.
+ */
+bool computeDistanceTransform(const std::string& dt_mode, GridGraph& graph);
+
+/**
+ * Stores the options which change the result of a query in a trace record, so
+ * the query can be replayed with the same settings.
+ */
+void recordPlannerOptions(const PlannerOptions& options, QueryRecord& record);
+
+/**
+ * Restores the options stored by recordPlannerOptions().
+ * @param  record   The trace record.
+ * @param  algo     The planning algorithm the options are for.
+ * @param  options  The options to update.
+ * @return  False if the record has no options and the result of the planning
+ *          algorithm depends on them, so the query can't be reproduced.
+ */
+bool restorePlannerOptions(const QueryRecord& record, const std::string& algo, PlannerOptions& options);
+
+/**
+ * Builds the data the planner keeps with the graph, like the clearance layer
+ * or the roadmap, unless it is already current. planPath() does this when
+ * needed, so this is only useful to keep the work out of the search time.
+ * @param  algo     The name of the planning algorithm.
+ * @param  graph    The graph to plan on, with its distance transform.
+ * @param  options  Settings used by some of the planners.
+ */
+void buildPlannerCaches(const std::string& algo, GridGraph& graph, const PlannerOptions& options);
+
+/**
+ * Plans a path with the planning algorithm of the given name. Valid names are
+ * "dfs", "bfs", "astar", "c2f", "lattice", "castar", "roadmap" and "portfolio",
+ * which runs the planners in options.portfolio at once and keeps the first path
+ * found.
+ * @param  algo     The name of the planning algorithm.
+ * @param  graph    The graph to search.
+ * @param  start    The start cell.
+ * @param  goal     The goal cell.
+ * @param  options  Settings used by some of the planners.
+ * @param  summary  If not null, filled in with what was found besides the path.
+ * @return  The path, or an empty path if none was found or the name is not valid.
+ */
+std::vector<Cell> planPath(const std::string& algo, GridGraph& graph, const Cell& start,
+                           const Cell& goal, const PlannerOptions& options = PlannerOptions(),
+                           PlanSummary* summary = nullptr);
+
+/**
+ * Plans a path with a planner for which isSharedGraphPlanner() is true,
+ * keeping the visited cells and search status in the scratch. The caches on
+ * the graph are used when they are current. Otherwise they are built for this
+ * query only, since the graph is not changed.
+ * @param  algo     The name of the planning algorithm.
+ * @param  graph    The graph to search.
+ * @param  scratch  The state of this search.
+ * @param  start    The start cell.
+ * @param  goal     The goal cell.
+ * @param  options  Settings used by some of the planners.
+ * @param  summary  If not null, filled in with what was found besides the path.
+ * @return  The path, or an empty path if none was found or the planner can't
+ *          run on a shared graph.
+ */
+std::vector<Cell> planPath(const std::string& algo, const GridGraph& graph, SearchScratch& scratch,
+                           const Cell& start, const Cell& goal, const PlannerOptions& options = PlannerOptions(),
+                           PlanSummary* summary = nullptr);
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_PLANNER_H
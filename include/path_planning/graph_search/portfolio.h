@@ -0,0 +1,78 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_PORTFOLIO_H
+#define PATH_PLANNING_GRAPH_SEARCH_PORTFOLIO_H
+
+#include <map>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/graph_search/planner.h>
+
+
+struct PortfolioResult
+{
+    std::vector<Cell> path;  // The winning path, or an empty path if no planner found one.
+    std::string winner;      // The planner which found the path first, or empty.
+    uint64_t elapsed_us;     // Time from the start of the portfolio to the winning path, in microseconds.
+};
+
+
+/**
+ * Win counts of each planner, per map. Stored as text with one
+ * "map_hash algo wins" line per entry.
+ */
+struct PortfolioStats
+{
+    std::map<uint64_t, std::map<std::string, int> > wins;  // Map hash -> planner -> wins.
+};
+
+
+/**
+ * Reads portfolio statistics from a file. A missing file gives empty stats.
+ * @return  False if the file exists but could not be read.
+ */
+bool loadPortfolioStats(const std::string& file_path, PortfolioStats& stats);
+
+/**
+ * Writes portfolio statistics to a file, replacing its contents.
+ */
+bool savePortfolioStats(const std::string& file_path, const PortfolioStats& stats);
+
+/**
+ * Orders the planners by how often they won on the map, then by how often
+ * they won on any map. Planners with equal counts keep their given order.
+ * @param  algos     The planner names.
+ * @param  stats     The win counts.
+ * @param  map_hash  The hash of the map to plan on. See hashMap().
+ */
+std::vector<std::string> orderPortfolio(const std::vector<std::string>& algos, const PortfolioStats& stats,
+                                        uint64_t map_hash);
+
+/**
+ * Checks that the path goes from start to goal through adjacent cells, none
+ * of which are in collision. The integer distance transform check is used if
+ * it was computed.
+ */
+bool isValidPath(const std::vector<Cell>& path, const Cell& start, const Cell& goal, const GridGraph& graph);
+
+/**
+ * Runs several planners at once and returns the first valid path. Only
+ * planners for which isPortfolioPlanner() is true are run, so the path kept
+ * does not depend on which planner happens to finish first. The planners
+ * share the graph and keep their search state in a scratch each. Caches they
+ * read are built before the threads start. Once a
+ * planner wins, the others are cancelled through their scratch. Planners are
+ * started in the order given, at most max_threads at a time, and the visited
+ * cells of the winner are copied into the graph.
+ * @param  algos        The planner names, as for planPath().
+ * @param  graph        The graph to plan on.
+ * @param  start        The start cell.
+ * @param  goal         The goal cell.
+ * @param  options      Settings used by some of the planners.
+ * @param  max_threads  The number of planners to run at once. 0 uses one per hardware thread.
+ */
+PortfolioResult runPortfolio(const std::vector<std::string>& algos, GridGraph& graph, const Cell& start,
+                             const Cell& goal, const PlannerOptions& options, int max_threads = 0);
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_PORTFOLIO_H
@@ -0,0 +1,128 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_ROADMAP_H
+#define PATH_PLANNING_GRAPH_SEARCH_ROADMAP_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+#include <path_planning/utils/graph_utils.h>
+
+#define ROADMAP_NODE_SPACING 10   // Longest chain of skeleton cells between two roadmap nodes.
+#define ROADMAP_MIN_SPUR 5        // Dead end branches of the skeleton shorter than this are removed, in cells.
+#define ROADMAP_LOCAL_NODES 4     // Number of roadmap nodes the start and goal are connected to.
+
+
+/**
+ * A sparse graph along the generalized Voronoi diagram of the free space, the
+ * cells furthest from obstacles. Nodes are skeleton cells at junctions, dead
+ * ends, and along long chains. Edges are stored in compressed sparse row
+ * form, once in each direction, and each edge keeps the chain of cells it
+ * follows so paths can be turned back into cells.
+ */
+struct Roadmap
+{
+    uint64_t map_hash;        // Hash of the map the roadmap was built from. See hashMap().
+    uint64_t dt_hash;         // Hash of the distance transform it was built from. See hashDistanceTransform().
+    float collision_radius;   // The collision radius the roadmap was built with.
+    uint32_t collision_sq_threshold;  // The graph.collision_sq_threshold it was built with.
+    int width, height;        // Size of the map in cells.
+    uint32_t dt_version;      // The graph.dt_version it was built or loaded for. Not saved, since versions only count
+                              // up within one run.
+
+    std::vector<int> node_cells;      // Cell index of each node.
+    std::vector<int> offsets;         // Edges of node n are at [offsets[n], offsets[n + 1]).
+    std::vector<int> targets;         // Node each edge leads to.
+    std::vector<float> weights;       // Length of each edge, in cells.
+    std::vector<int> edge_ids;        // Undirected edge of each edge, shared by both directions.
+    std::vector<int> chain_offsets;   // Cells of undirected edge e are at [chain_offsets[e], chain_offsets[e + 1]).
+    std::vector<int> chain_cells;     // Cells between the two nodes of each edge, from the lower node index.
+
+    std::unordered_map<int, int> node_at;  // Node at each cell index. Rebuilt on load, not saved.
+};
+
+
+/**
+ * Builds the roadmap from the distance transform. The free space is thinned
+ * to a skeleton by removing cells in order of increasing distance from
+ * obstacles whenever doing so keeps the connectivity of the free space, so
+ * what remains runs along the ridges of the distance transform.
+ *
+ * Warning: A distance transform must be computed for this function to work.
+ * @param  graph         The graph to build the roadmap for.
+ * @param  roadmap       The roadmap to fill.
+ * @param  node_spacing  The longest chain of cells between two nodes.
+ * @param  min_spur      Dead end branches shorter than this are removed, in cells.
+ * @return  False if there is no distance transform.
+ */
+bool buildRoadmap(const GridGraph& graph, Roadmap& roadmap, int node_spacing = ROADMAP_NODE_SPACING,
+                  int min_spur = ROADMAP_MIN_SPUR);
+
+/**
+ * Gives the roadmap file stored with a map file, by replacing the ".map"
+ * extension with ".roadmap".
+ */
+std::string roadmapFilePath(const std::string& map_file);
+
+/**
+ * Writes the roadmap to a binary file. Empty roadmaps are not saved, since
+ * they usually come from a missing or broken distance transform.
+ * @return  False if the roadmap is empty or the file could not be written.
+ */
+bool saveRoadmap(const std::string& file_path, const Roadmap& roadmap);
+
+/**
+ * Reads a roadmap from a binary file.
+ * @param  file_path  The file to read.
+ * @param  graph      The graph the roadmap should be for.
+ * @param  roadmap    The roadmap to fill.
+ * @return  False if the file does not exist, can't be read, or was built for a
+ *          different map, distance transform or collision radius.
+ */
+bool loadRoadmap(const std::string& file_path, const GridGraph& graph, Roadmap& roadmap);
+
+/**
+ * Checks whether the roadmap was built for the graph's current distance
+ * transform and collision radius.
+ */
+bool isRoadmapCurrent(const GridGraph& graph, const Roadmap& roadmap);
+
+/**
+ * Loads the roadmap from a file, or builds it if the file is missing or out
+ * of date and then saves it there.
+ * @param  graph      The graph to build the roadmap for.
+ * @param  file_path  The roadmap file. Empty to always build the roadmap and not save it.
+ * @param  roadmap    The roadmap to fill.
+ */
+void loadOrBuildRoadmap(const GridGraph& graph, const std::string& file_path, Roadmap& roadmap);
+
+/**
+ * Returns the roadmap cached in graph.roadmap, loading or building it first
+ * if the distance transform or collision radius changed since. See
+ * loadOrBuildRoadmap().
+ * @param  graph      The graph to build the roadmap for.
+ * @param  file_path  The roadmap file. Empty to not keep one.
+ */
+const Roadmap& getRoadmap(GridGraph& graph, const std::string& file_path = "");
+
+/**
+ * Plans a path by connecting the start and goal to nearby roadmap nodes with a
+ * local search, then running Dijkstra on the roadmap. If the local search from
+ * the start reaches the goal first, that path is used directly.
+ * @param  graph        The graph to search.
+ * @param  roadmap      The roadmap of the graph.
+ * @param  start        The start cell.
+ * @param  goal         The goal cell.
+ * @param  local_nodes  The number of roadmap nodes to connect the start and goal to.
+ */
+std::vector<Cell> roadmapSearch(GridGraph& graph, const Roadmap& roadmap, const Cell& start, const Cell& goal,
+                                int local_nodes = ROADMAP_LOCAL_NODES);
+
+/**
+ * Runs the same search, keeping the visited cells and search status in the
+ * given scratch so the graph is only read.
+ */
+std::vector<Cell> roadmapSearch(const GridGraph& graph, SearchScratch& scratch, const Roadmap& roadmap,
+                                const Cell& start, const Cell& goal, int local_nodes = ROADMAP_LOCAL_NODES);
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_ROADMAP_H
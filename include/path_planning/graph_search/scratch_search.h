@@ -0,0 +1,42 @@
+#ifndef PATH_PLANNING_GRAPH_SEARCH_SCRATCH_SEARCH_H
+#define PATH_PLANNING_GRAPH_SEARCH_SCRATCH_SEARCH_H
+
+#include <vector>
+
+#include <path_planning/utils/graph_utils.h>
+
+
+/**
+ * Breadth first and A-star searches which keep their node data in a NodeStore
+ * and their visited cells in a scratch, so several can run on one graph at
+ * once. They are separate from the searches in graph_search.h, which keep
+ * their node data in the graph. Both are 8-connected, check collisions with
+ * checkCollisionFast() and stop early when the scratch is cancelled.
+ */
+
+/**
+ * Finds the path with the fewest steps from start to goal.
+ * @param  graph    The graph to search. The distance transform must be computed.
+ * @param  scratch  The state of this search.
+ * @param  start    The start cell.
+ * @param  goal     The goal cell.
+ * @return  The path, or an empty path if none was found.
+ */
+std::vector<Cell> scratchBreadthFirstSearch(const GridGraph& graph, SearchScratch& scratch,
+                                            const Cell& start, const Cell& goal);
+std::vector<Cell> scratchBreadthFirstSearch(GridGraph& graph, const Cell& start, const Cell& goal);
+
+/**
+ * Finds the shortest path from start to goal, with diagonal steps of length
+ * sqrt(2), using the octile distance as the heuristic.
+ * @param  graph    The graph to search. The distance transform must be computed.
+ * @param  scratch  The state of this search.
+ * @param  start    The start cell.
+ * @param  goal     The goal cell.
+ * @return  The path, or an empty path if none was found.
+ */
+std::vector<Cell> scratchAStarSearch(const GridGraph& graph, SearchScratch& scratch,
+                                     const Cell& start, const Cell& goal);
+std::vector<Cell> scratchAStarSearch(GridGraph& graph, const Cell& start, const Cell& goal);
+
+#endif  // PATH_PLANNING_GRAPH_SEARCH_SCRATCH_SEARCH_H
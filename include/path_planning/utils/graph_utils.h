@@ -1,11 +1,17 @@
 #ifndef PATH_PLANNING_GRAPH_SEARCH_GRAPH_UTILS_H
 #define PATH_PLANNING_GRAPH_SEARCH_GRAPH_UTILS_H
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <string>
+#include <cstdint>
 
 #define HIGH 1e6
 #define ROBOT_RADIUS 0.137
+#define NODE_MEMORY_CAP (size_t(512) << 20)  // Default cap on the memory used for search node data, in bytes.
+#define SEARCH_CANCEL_INTERVAL 256             // Expansions between checks of the cancel flag.
 
 
 struct Cell
@@ -14,6 +20,47 @@ struct Cell
 };
 
 
+/**
+ * Policies for recording which cells a search visits. Recording is only used
+ * for visualization, so long searches can turn it off or use a compact policy.
+ */
+enum VisitedPolicy
+{
+    VISITED_OFF,        // Don't record visited cells.
+    VISITED_ALL,        // Record every visited cell, in order.
+    VISITED_BITMAP,     // Keep one bit per cell. Visit order is not kept.
+    VISITED_EVERY_NTH,  // Record every Nth visited cell, in order.
+    VISITED_RING        // Keep only the most recent visited cells, in order.
+};
+
+
+/**
+ * Backends for storing per search node data. See node_store.h.
+ */
+enum NodeStorage
+{
+    NODES_AUTO,    // Pick dense or sparse storage from the map size and expected search extent.
+    NODES_DENSE,   // Keep a record for every cell.
+    NODES_SPARSE   // Keep records only for reached cells, in a hash table.
+};
+
+
+/**
+ * Why a search which uses a NodeStore stopped, so callers can tell a search
+ * which ran out of memory from one which found there is no path.
+ */
+enum SearchStatus
+{
+    SEARCH_DONE,       // The search finished. It found a path if there is one.
+    SEARCH_MEMORY_CAP  // The search stopped at the node memory cap.
+};
+
+
+struct MapPyramid;  // See coarse_to_fine.h.
+struct ClearanceLayer;  // See clearance_cost.h.
+struct Roadmap;  // See roadmap.h.
+
+
 /**
  * TODO (P3): Define a CellNode struct to store information you need for path
  * planning.
@@ -24,7 +71,35 @@ struct Cell
  */
 
 
-struct GridGraph
+/**
+ * The state a search changes as it runs. A GridGraph holds one for searches
+ * run on the graph itself. Searches which also take a separate scratch only
+ * read the graph, so several of them can share one graph across threads.
+ */
+struct SearchScratch
+{
+    SearchScratch() :
+        visited_policy(VISITED_ALL),
+        visited_param(1),
+        visited_count(0),
+        search_status(SEARCH_DONE),
+        cancel(nullptr)
+    {
+    };
+
+    VisitedPolicy visited_policy;           // How visited cells are recorded. Used for visualization.
+    int visited_param;                      // N for VISITED_EVERY_NTH, capacity for VISITED_RING.
+    int visited_count;                      // Number of visits reported in the current search.
+    std::vector<Cell> visited_cells;        // Recorded visited cells (list or ring buffer, by policy).
+    std::vector<uint64_t> visited_bits;     // One bit per cell for VISITED_BITMAP.
+
+    SearchStatus search_status;             // How the last search which uses a NodeStore stopped. Reset by
+                                            // initSearchScratch().
+    const std::atomic<bool>* cancel;        // If set and true, the current search should stop. See isSearchCancelled().
+};
+
+
+struct GridGraph : SearchScratch
 {
     GridGraph() :
         width(-1),
@@ -33,7 +108,11 @@ struct GridGraph
         origin_y(0),
         meters_per_cell(0),
         collision_radius(0.15),
-        threshold(-100)  // TODO: Adjust threshold.
+        collision_sq_threshold(0),
+        threshold(-100),  // TODO: Adjust threshold.
+        dt_version(0),
+        node_storage(NODES_AUTO),
+        node_memory_cap(NODE_MEMORY_CAP)
     {
     };
 
@@ -41,12 +120,22 @@ struct GridGraph
     float origin_x, origin_y;               // The (x, y) coordinate corresponding to cell (0, 0) in meters.
     float meters_per_cell;                  // Width of a cell in meters.
     float collision_radius;                 // The radius to use to check collisions.
+    uint32_t collision_sq_threshold;        // The squared collision radius in cells, for the integer distance transform.
     int8_t threshold;                       // Threshold to check if a cell is occupied or not.
 
     std::vector<int8_t> cell_odds;          // The odds that a cell is occupied.
-    std::vector<float> obstacle_distances;  // The distance from each cell to the nearest obstacle.
-
-    std::vector<Cell> visited_cells;        // A list of visited cells. Used for visualization.
+    std::vector<float> obstacle_distances;  // The distance from each cell to the nearest obstacle. Empty until a float
+                                            // distance transform is computed.
+    std::vector<uint16_t> obstacle_sq_distances;  // Squared distance to the nearest obstacle in cells, saturated at
+                                                  // UINT16_MAX. Used instead of obstacle_distances when not empty.
+    uint32_t dt_version;                    // Incremented whenever the distance transform is computed.
+    std::vector<uint8_t> search_mask;       // If not empty, cells with a zero value are treated as in collision.
+    std::shared_ptr<const MapPyramid> pyramid;  // Occupancy pyramid for coarse-to-fine search. See getMapPyramid().
+    std::shared_ptr<const ClearanceLayer> clearance;  // Clearance costs for castar. See getClearanceLayer().
+    std::shared_ptr<const Roadmap> roadmap;     // Voronoi roadmap for the roadmap planner. See getRoadmap().
+
+    NodeStorage node_storage;               // How searches which use a NodeStore keep node data.
+    size_t node_memory_cap;                 // The most memory those searches may use for node data, in bytes.
 
     /**
      * TODO (P3): Define the structures you need to store node data in the graph.
@@ -79,6 +168,56 @@ std::string mapAsString(GridGraph& graph);
  */
 void initGraph(GridGraph& graph);
 
+/**
+ * Clears the visited cell record and search status of a scratch before a
+ * search of the graph. initGraph() does this for the graph's own scratch.
+ * @param  graph    The graph to be searched.
+ * @param  scratch  The scratch to reset.
+ */
+void initSearchScratch(const GridGraph& graph, SearchScratch& scratch);
+
+/**
+ * Clears the visited cell record. Called by initGraph() before every search.
+ * @param  graph  The graph to reset.
+ */
+void resetVisited(GridGraph& graph);
+void resetVisited(const GridGraph& graph, SearchScratch& scratch);
+
+/**
+ * Sets the visited cell recording policy from a string. Valid values are
+ * "off", "all", "bitmap", "nth:N" (every Nth visit) and "ring:N" (last N
+ * visits).
+ * @param  spec   The policy description.
+ * @param  graph  The graph to configure.
+ * @return  True if the policy was valid.
+ */
+bool setVisitedPolicy(const std::string& spec, GridGraph& graph);
+
+/**
+ * Records that a search visited the given cell, according to the policy in
+ * graph.visited_policy. Searches should call this instead of pushing to
+ * graph.visited_cells directly.
+ * @param  c      The visited cell.
+ * @param  graph  The graph the cell belongs to.
+ */
+void recordVisited(const Cell& c, GridGraph& graph);
+void recordVisited(const Cell& c, const GridGraph& graph, SearchScratch& scratch);
+
+/**
+ * Returns the recorded visited cells as a list, whatever the recording policy.
+ * Ring buffers are returned oldest first and bitmaps in index order.
+ * @param  graph  The graph the cells belong to.
+ */
+std::vector<Cell> getVisitedCells(const GridGraph& graph);
+
+/**
+ * Checks whether the search was cancelled through scratch.cancel. Long
+ * running searches should check this every SEARCH_CANCEL_INTERVAL expansions
+ * and return an empty path.
+ * @param  scratch  The scratch of the search, or the graph being searched.
+ */
+bool isSearchCancelled(const SearchScratch& scratch);
+
 /**
  * Converts a cell coordinate to the corresponding index in the graph.
  * @param  i      The row index of the cell in the graph.
@@ -145,12 +284,20 @@ bool isCellOccupied(int i, int j, const GridGraph& graph);
  */
 std::vector<int> findNeighbors(int idx, const GridGraph& graph);
 
+/**
+ * Updates graph.collision_sq_threshold from graph.collision_radius. Call this
+ * after changing the collision radius if using the integer distance transform.
+ * @param  graph  The graph to update.
+ */
+void updateCollisionThreshold(GridGraph& graph);
+
 /**
  * Checks whether the provided index in the graph is within the defined
- * collision radius of an obstacle using the distance transform.
+ * collision radius of an obstacle using the distance transform. Cells outside
+ * graph.search_mask are also reported as in collision.
  *
  * Warning: Distance transform values must be stored in graph.obstacle_distances
- * for this function to work.
+ * (or graph.obstacle_sq_distances) for this function to work.
  * @param  idx    The index of the cell in the graph data.
  * @param  graph  The graph the cell belongs to.
  */
@@ -159,7 +306,8 @@ bool checkCollisionFast(int idx, const GridGraph& graph);
 /**
  * Checks whether the provided index in the graph is within the defined
  * collision radius of an obstacle by checking all the cells in a radius of the
- * given index.
+ * given index. Cells outside graph.search_mask are also reported as in
+ * collision.
  * @param  idx    The index of the cell in the graph data.
  * @param  graph  The graph the cell belongs to.
  */
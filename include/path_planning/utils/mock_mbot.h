@@ -0,0 +1,97 @@
+#ifndef PATH_PLANNING_UTILS_MOCK_MBOT_H
+#define PATH_PLANNING_UTILS_MOCK_MBOT_H
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <sstream>
+#include <iostream>
+
+#include "math_helpers.h"
+
+/**
+ * A local stand in for mbot_bridge::MBot, so robot programs can be built and
+ * run on a laptop. The pose is read from the MOCK_MBOT_POSE environment
+ * variable as "x,y,theta" (default "0,0,0"). If MOCK_MBOT_POSE_DELAY is set,
+ * readSlamPose() waits that many seconds first, like waiting on SLAM. Values
+ * which can't be parsed are ignored with a warning.
+ */
+namespace mbot_bridge
+{
+
+class MBot
+{
+public:
+    MBot()
+    {
+        const char* pose = std::getenv("MOCK_MBOT_POSE");
+        if (pose != nullptr)
+        {
+            std::stringstream ss(pose);
+            std::string value;
+            std::vector<float> parsed;
+            float x;
+            while (std::getline(ss, value, ',') && parseFloat(value, x)) parsed.push_back(x);
+            if (ss.eof() && parsed.size() == 3) pose_ = parsed;
+            else std::cerr << "WARNING: MockMBot: Ignoring MOCK_MBOT_POSE=\"" << pose << "\"." << std::endl;
+        }
+
+        const char* delay = std::getenv("MOCK_MBOT_POSE_DELAY");
+        if (delay != nullptr && !parseFloat(delay, pose_delay_))
+        {
+            std::cerr << "WARNING: MockMBot: Ignoring MOCK_MBOT_POSE_DELAY=\"" << delay << "\"." << std::endl;
+        }
+    };
+
+    std::vector<float> readSlamPose()
+    {
+        if (pose_delay_ > 0) sleepFor(pose_delay_);
+        return pose_;
+    };
+
+    void drivePath(const std::vector<std::array<float, 3> >& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::cout << "[MockMBot] Driving path with " << path.size() << " poses";
+        if (path.size() > 0)
+        {
+            std::cout << " ending at (" << path.back()[0] << ", " << path.back()[1] << ")";
+        }
+        std::cout << std::endl;
+        driven_paths_.push_back(path);
+    };
+
+    /**
+     * Returns every path passed to drivePath(), for checking in tests.
+     */
+    std::vector<std::vector<std::array<float, 3> > > drivenPaths()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return driven_paths_;
+    };
+
+private:
+    /**
+     * Parses the whole string as a float.
+     * @return  False if the string is not a number. The value is not changed.
+     */
+    static bool parseFloat(const std::string& str, float& value)
+    {
+        char* end = nullptr;
+        float parsed = std::strtof(str.c_str(), &end);
+        if (str.empty() || *end != '\0') return false;
+        value = parsed;
+        return true;
+    };
+
+    std::vector<float> pose_ = {0, 0, 0};
+    float pose_delay_ = 0;
+    std::mutex mutex_;
+    std::vector<std::vector<std::array<float, 3> > > driven_paths_;
+};
+
+}  // namespace mbot_bridge
+
+#endif // PATH_PLANNING_UTILS_MOCK_MBOT_H
@@ -0,0 +1,84 @@
+#ifndef PATH_PLANNING_UTILS_QUERY_TRACE_H
+#define PATH_PLANNING_UTILS_QUERY_TRACE_H
+
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "graph_utils.h"
+
+
+/**
+ * One planning query in a trace file. Records are written field by field in
+ * the machine's byte order after an 8 byte "PPTRACE2" header.
+ */
+struct QueryRecord
+{
+    uint64_t map_hash;          // Hash of the map the query was planned on. See hashMap().
+    int32_t start_i, start_j;   // Start cell.
+    int32_t goal_i, goal_j;     // Goal cell.
+    char algo[16];              // Name of the planning algorithm, null terminated.
+    char dt_mode[8];            // Name of the distance transform, null terminated.
+    float collision_radius;     // Collision radius used, in meters.
+    uint32_t path_length;       // Number of cells in the resulting path. 0 if none was found.
+    uint32_t expansions;        // Number of visited cells reported by the search.
+    uint32_t load_us;           // Time to load the map, in microseconds.
+    uint32_t dt_us;             // Time for the distance transform and planner caches, in microseconds.
+    uint32_t search_us;         // Time for the search, in microseconds.
+    uint32_t total_us;          // Total time for the query, in microseconds.
+
+    // Planner options which change the result. See recordPlannerOptions().
+    uint8_t has_options;           // 0 if the options were too long to record.
+    float footprint_length;        // Lattice footprint length, in meters.
+    float footprint_width;         // Lattice footprint width, in meters.
+    uint8_t clearance_decay;       // Clearance cost decay, a ClearanceDecay value.
+    float clearance_radius;        // Clearance influence radius, in meters.
+    float clearance_decay_length;  // Clearance exponential decay length, in meters.
+    float clearance_weight;        // Clearance cost weight.
+    char portfolio[64];            // Comma separated planners run by the portfolio, null terminated.
+};
+
+
+/**
+ * Gets a monotonic time in microseconds, for timing the phases of a query.
+ */
+static inline uint64_t traceTimeMicro()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+/**
+ * Computes a hash of the map header and cell data, used to check whether a
+ * query is replayed on the same map it was recorded on.
+ */
+uint64_t hashMap(const GridGraph& graph);
+
+/**
+ * Computes a hash of the distance transform values, integer or float, used to
+ * check whether data built from a distance transform is still valid.
+ */
+uint64_t hashDistanceTransform(const GridGraph& graph);
+
+/**
+ * Fills the fields of a record which describe the query and its result.
+ * Timings are left at zero.
+ */
+QueryRecord makeQueryRecord(const GridGraph& graph, const Cell& start, const Cell& goal,
+                            const std::string& algo, const std::string& dt_mode,
+                            const std::vector<Cell>& path);
+
+/**
+ * Appends a record to the trace file, creating it if needed.
+ * @return  True if the record was written.
+ */
+bool appendQueryRecord(const std::string& trace_file, const QueryRecord& record);
+
+/**
+ * Reads every record in the trace file.
+ * @return  True if the file is a valid trace.
+ */
+bool readQueryTrace(const std::string& trace_file, std::vector<QueryRecord>& records);
+
+#endif // PATH_PLANNING_UTILS_QUERY_TRACE_H
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <cmath>
+#include <iostream>
 
 #include "graph_utils.h"
 
@@ -27,21 +29,35 @@ static inline void generatePlanFile(const Cell& start, const Cell& goal,
             outfile << ",";
     }
 
+    std::vector<Cell> visited_cells = getVisitedCells(graph);
     outfile << "], \"visited_cells\":[";
-    for (int k = 0; k < graph.visited_cells.size(); ++k)
+    for (int k = 0; k < visited_cells.size(); ++k)
     {
-        outfile << "[" + std::to_string(graph.visited_cells[k].i) + "," + std::to_string(graph.visited_cells[k].j) + "]";
-        if (k != graph.visited_cells.size() - 1)
+        outfile << "[" + std::to_string(visited_cells[k].i) + "," + std::to_string(visited_cells[k].j) + "]";
+        if (k != visited_cells.size() - 1)
             outfile << ",";
     }
     outfile << "]";
 
     outfile << ", \"dt\":[";
-    for (int k = 0; k < graph.obstacle_distances.size(); ++k)
+    if (!graph.obstacle_sq_distances.empty())
     {
-        outfile << std::to_string(graph.obstacle_distances[k]);
-        if (k != graph.obstacle_distances.size() - 1)
-            outfile << ",";
+        // The integer distance transform is in use, so save its distances instead.
+        for (int k = 0; k < graph.obstacle_sq_distances.size(); ++k)
+        {
+            outfile << std::to_string(std::sqrt(static_cast<float>(graph.obstacle_sq_distances[k])));
+            if (k != graph.obstacle_sq_distances.size() - 1)
+                outfile << ",";
+        }
+    }
+    else
+    {
+        for (int k = 0; k < graph.obstacle_distances.size(); ++k)
+        {
+            outfile << std::to_string(graph.obstacle_distances[k]);
+            if (k != graph.obstacle_distances.size() - 1)
+                outfile << ",";
+        }
     }
     outfile << "]";
 
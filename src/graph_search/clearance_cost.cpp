@@ -0,0 +1,219 @@
+#include <cmath>
+#include <memory>
+#include <queue>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <path_planning/utils/math_helpers.h>
+#include <path_planning/utils/graph_utils.h>
+
+#include <path_planning/graph_search/node_store.h>
+#include <path_planning/graph_search/clearance_cost.h>
+
+
+/**
+ * Clearance cost for a distance from the nearest obstacle, in meters.
+ */
+static uint8_t clearanceCost(float dist, float collision_radius, const ClearanceProfile& profile)
+{
+    float margin = dist - collision_radius;
+    if (margin <= 0) return 255;
+    if (margin >= profile.influence_radius) return 0;
+
+    float scale = 0;
+    if (profile.decay == CLEARANCE_LINEAR)
+    {
+        scale = 1 - margin / profile.influence_radius;
+    }
+    else
+    {
+        scale = std::exp(-margin / profile.decay_length);
+    }
+    return static_cast<uint8_t>(std::round(255 * scale));
+}
+
+
+bool isClearanceLayerCurrent(const GridGraph& graph, const ClearanceLayer& layer, const ClearanceProfile& profile)
+{
+    bool same_profile = layer.profile.decay == profile.decay &&
+                        layer.profile.influence_radius == profile.influence_radius &&
+                        layer.profile.decay_length == profile.decay_length &&
+                        layer.profile.weight == profile.weight;
+    return layer.costs.size() == size_t(graph.width) * graph.height && layer.dt_version == graph.dt_version &&
+           layer.collision_radius == graph.collision_radius && same_profile;
+}
+
+
+bool updateClearanceLayer(const GridGraph& graph, ClearanceLayer& layer, const ClearanceProfile& profile)
+{
+    if (isClearanceLayerCurrent(graph, layer, profile)) return false;
+
+    if (graph.obstacle_sq_distances.empty() && graph.obstacle_distances.size() != size_t(graph.width) * graph.height)
+    {
+        std::cerr << "ERROR: updateClearanceLayer: No distance transform has been computed." << std::endl;
+        layer.costs.clear();
+        return false;
+    }
+
+    layer.dt_version = graph.dt_version;
+    layer.collision_radius = graph.collision_radius;
+    layer.profile = profile;
+    for (int c = 0; c < 256; ++c) layer.penalty[c] = profile.weight * c / 255;
+
+    int num_cells = graph.width * graph.height;
+    layer.costs.resize(num_cells);
+
+    if (!graph.obstacle_sq_distances.empty())
+    {
+        // Squared distances are small integers near obstacles, so the cost of
+        // each one is computed once and looked up.
+        float max_dist = (graph.collision_radius + profile.influence_radius) / graph.meters_per_cell;
+        int lut_size = static_cast<int>(std::ceil(max_dist * max_dist)) + 1;
+        std::vector<uint8_t> lut(lut_size);
+        for (int sq = 0; sq < lut_size; ++sq)
+        {
+            lut[sq] = clearanceCost(std::sqrt(float(sq)) * graph.meters_per_cell, graph.collision_radius, profile);
+        }
+
+        for (int idx = 0; idx < num_cells; ++idx)
+        {
+            uint16_t sq = graph.obstacle_sq_distances[idx];
+            layer.costs[idx] = sq < lut_size ? lut[sq] : 0;
+        }
+    }
+    else
+    {
+        for (int idx = 0; idx < num_cells; ++idx)
+        {
+            float dist = graph.obstacle_distances[idx] * graph.meters_per_cell;
+            layer.costs[idx] = clearanceCost(dist, graph.collision_radius, profile);
+        }
+    }
+
+    return true;
+}
+
+
+const ClearanceLayer& getClearanceLayer(GridGraph& graph, const ClearanceProfile& profile)
+{
+    if (!graph.clearance || !isClearanceLayerCurrent(graph, *graph.clearance, profile))
+    {
+        std::shared_ptr<ClearanceLayer> layer = std::make_shared<ClearanceLayer>();
+        updateClearanceLayer(graph, *layer, profile);
+        graph.clearance = layer;
+    }
+    return *graph.clearance;
+}
+
+
+ClearanceResult clearanceAStarSearch(GridGraph& graph, const ClearanceLayer& layer,
+                                     const Cell& start, const Cell& goal)
+{
+    return clearanceAStarSearch(graph, graph, layer, start, goal);
+}
+
+
+ClearanceResult clearanceAStarSearch(const GridGraph& graph, SearchScratch& scratch, const ClearanceLayer& layer,
+                                     const Cell& start, const Cell& goal)
+{
+    ClearanceResult result = {std::vector<Cell>(), 0, 0, 0};
+
+    initSearchScratch(graph, scratch);  // Make sure the visited cells are reset.
+
+    if (!isCellInBounds(start.i, start.j, graph) || !isCellInBounds(goal.i, goal.j, graph) ||
+        layer.costs.size() != size_t(graph.width) * graph.height)
+    {
+        return result;
+    }
+
+    // Octile distance is the exact cost on an empty 8-connected grid.
+    auto heuristic = [&](int i, int j)
+    {
+        int di = std::abs(goal.i - i), dj = std::abs(goal.j - j);
+        return float(std::max(di, dj) + (M_SQRT2 - 1) * std::min(di, dj));
+    };
+
+    NodeStore nodes;
+    initNodeStore(nodes, graph, int64_t(graph.width) * graph.height, estimateSearchNodes(graph, start, goal));
+
+    typedef std::pair<float, int> QueueItem;  // Estimated total cost, index.
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > open;
+
+    int start_idx = cellToIdx(start.i, start.j, graph);
+    int goal_idx = cellToIdx(goal.i, goal.j, graph);
+    getNode(nodes, start_idx)->cost = 0;
+    open.push({heuristic(start.i, start.j), start_idx});
+
+    const int di[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    const int dj[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+    bool found = false;
+    int expansions = 0;
+    while (!open.empty())
+    {
+        if (++expansions % SEARCH_CANCEL_INTERVAL == 0 && isSearchCancelled(scratch)) return result;
+
+        int idx = open.top().second;
+        open.pop();
+
+        NodeRecord* node = findNode(nodes, idx);
+        if (node->closed) continue;  // Stale queue entry.
+        node->closed = true;
+        float cost = node->cost;
+
+        if (idx == goal_idx)
+        {
+            found = true;
+            break;
+        }
+
+        Cell c = idxToCell(idx, graph);
+        recordVisited(c, graph, scratch);
+
+        for (int n = 0; n < 8; ++n)
+        {
+            int ni = c.i + di[n], nj = c.j + dj[n];
+            if (!isCellInBounds(ni, nj, graph)) continue;
+
+            int n_idx = cellToIdx(ni, nj, graph);
+            if (checkCollisionFast(n_idx, graph)) continue;
+
+            NodeRecord* neighbor = getNode(nodes, n_idx);
+            if (neighbor == nullptr)
+            {
+                std::cerr << "ERROR: clearanceAStarSearch: Node memory cap of "
+                          << (nodes.memory_cap >> 20) << " MB reached." << std::endl;
+                scratch.search_status = SEARCH_MEMORY_CAP;
+                return result;
+            }
+
+            float step = (n < 4) ? 1 : M_SQRT2;
+            float next_cost = cost + step * (1 + layer.penalty[layer.costs[n_idx]]);
+            if (!neighbor->closed && next_cost < neighbor->cost)
+            {
+                neighbor->cost = next_cost;
+                neighbor->parent = idx;
+                open.push({next_cost + heuristic(ni, nj), n_idx});
+            }
+        }
+    }
+
+    if (!found) return result;
+
+    result.cost = findNode(nodes, goal_idx)->cost;
+    for (int cur = goal_idx; cur >= 0; cur = findNode(nodes, cur)->parent)
+    {
+        result.path.push_back(idxToCell(cur, graph));
+    }
+    std::reverse(result.path.begin(), result.path.end());
+
+    for (size_t k = 1; k < result.path.size(); ++k)
+    {
+        bool diagonal = result.path[k].i != result.path[k - 1].i && result.path[k].j != result.path[k - 1].j;
+        result.length += diagonal ? M_SQRT2 : 1;
+    }
+    result.clearance_cost = result.cost - result.length;
+
+    return result;
+}
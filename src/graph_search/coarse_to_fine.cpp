@@ -0,0 +1,215 @@
+#include <queue>
+#include <cstring>
+#include <algorithm>
+
+#include <path_planning/utils/graph_utils.h>
+
+#include <path_planning/graph_search/coarse_to_fine.h>
+
+
+/**
+ * Max pools a level by a factor of two. Coarse cells on the edge of an odd
+ * sized level only pool over the fine cells which exist. Each step works on
+ * whole contiguous rows so the compiler can vectorize the max operations.
+ */
+static MapLevel poolLevel(const MapLevel& fine)
+{
+    MapLevel coarse;
+    coarse.width = (fine.width + 1) / 2;
+    coarse.height = (fine.height + 1) / 2;
+    coarse.scale = fine.scale * 2;
+    coarse.blocked.resize(coarse.width * coarse.height);
+
+    // Row buffer padded to an even width. The padding copies the last column
+    // so it does not change the max.
+    std::vector<uint8_t> row_max(coarse.width * 2);
+
+    for (int j = 0; j < coarse.height; ++j)
+    {
+        // Pool the two rows. The last row of an odd height level has no pair.
+        const uint8_t* row_a = &fine.blocked[(2 * j) * fine.width];
+        const uint8_t* row_b = (2 * j + 1 < fine.height) ? row_a + fine.width : row_a;
+        for (int i = 0; i < fine.width; ++i)
+        {
+            row_max[i] = std::max(row_a[i], row_b[i]);
+        }
+        if (fine.width % 2 == 1) row_max[fine.width] = row_max[fine.width - 1];
+
+        // Pool neighboring columns. The row is read as consecutive byte pairs
+        // so the loop runs over contiguous memory.
+        uint8_t* out = &coarse.blocked[j * coarse.width];
+        for (int i = 0; i < coarse.width; ++i)
+        {
+            uint16_t pair;
+            std::memcpy(&pair, &row_max[2 * i], sizeof(pair));
+            out[i] = std::max(pair & 0xff, pair >> 8);
+        }
+    }
+
+    return coarse;
+}
+
+
+void buildMapPyramid(const GridGraph& graph, MapPyramid& pyramid, int min_size)
+{
+    pyramid.levels.clear();
+    pyramid.threshold = graph.threshold;
+
+    MapLevel base;
+    base.width = graph.width;
+    base.height = graph.height;
+    base.scale = 1;
+    base.blocked.resize(graph.width * graph.height);
+    for (size_t idx = 0; idx < base.blocked.size(); ++idx)
+    {
+        base.blocked[idx] = graph.cell_odds[idx] >= graph.threshold;
+    }
+    pyramid.levels.push_back(base);
+
+    while (pyramid.levels.back().width > min_size && pyramid.levels.back().height > min_size)
+    {
+        pyramid.levels.push_back(poolLevel(pyramid.levels.back()));
+    }
+}
+
+
+const MapPyramid& getMapPyramid(GridGraph& graph)
+{
+    if (!graph.pyramid || graph.pyramid->threshold != graph.threshold)
+    {
+        std::shared_ptr<MapPyramid> pyramid = std::make_shared<MapPyramid>();
+        buildMapPyramid(graph, *pyramid);
+        graph.pyramid = pyramid;
+    }
+    return *graph.pyramid;
+}
+
+
+/**
+ * Runs an 8-connected breadth first search on a pyramid level.
+ * @return  The level cells from start to goal, or an empty path.
+ */
+static std::vector<Cell> searchLevel(const MapLevel& level, const Cell& start, const Cell& goal)
+{
+    std::vector<Cell> path;
+    int start_idx = start.i + start.j * level.width;
+    int goal_idx = goal.i + goal.j * level.width;
+    if (level.blocked[start_idx] || level.blocked[goal_idx]) return path;
+
+    std::vector<int> parents(level.width * level.height, -2);  // -2 marks unvisited.
+    std::queue<int> open;
+    parents[start_idx] = -1;
+    open.push(start_idx);
+
+    while (!open.empty() && parents[goal_idx] == -2)
+    {
+        int idx = open.front();
+        open.pop();
+        int i = idx % level.width, j = idx / level.width;
+
+        for (int dj = -1; dj <= 1; ++dj)
+        {
+            for (int di = -1; di <= 1; ++di)
+            {
+                int ni = i + di, nj = j + dj;
+                if (ni < 0 || nj < 0 || ni >= level.width || nj >= level.height) continue;
+
+                int n_idx = ni + nj * level.width;
+                if (parents[n_idx] != -2 || level.blocked[n_idx]) continue;
+
+                parents[n_idx] = idx;
+                open.push(n_idx);
+            }
+        }
+    }
+
+    if (parents[goal_idx] == -2) return path;
+
+    for (int cur = goal_idx; cur >= 0; cur = parents[cur])
+    {
+        path.push_back({cur % level.width, cur / level.width});
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+
+/**
+ * Marks the map cells within radius level cells of the coarse path in the
+ * graph's search mask.
+ */
+static void setCorridorMask(GridGraph& graph, const MapLevel& level,
+                            const std::vector<Cell>& coarse_path, int radius)
+{
+    // Dilate the path on the coarse level first, since it is much smaller.
+    std::vector<uint8_t> corridor(level.width * level.height, 0);
+    for (const Cell& c : coarse_path)
+    {
+        for (int j = std::max(c.j - radius, 0); j <= std::min(c.j + radius, level.height - 1); ++j)
+        {
+            std::fill(corridor.begin() + j * level.width + std::max(c.i - radius, 0),
+                      corridor.begin() + j * level.width + std::min(c.i + radius, level.width - 1) + 1,
+                      1);
+        }
+    }
+
+    graph.search_mask.assign(graph.width * graph.height, 0);
+    for (int j = 0; j < graph.height; ++j)
+    {
+        const uint8_t* coarse_row = &corridor[(j / level.scale) * level.width];
+        uint8_t* mask_row = &graph.search_mask[j * graph.width];
+        for (int i = 0; i < graph.width; ++i)
+        {
+            mask_row[i] = coarse_row[i / level.scale];
+        }
+    }
+}
+
+
+std::vector<Cell> coarseToFineSearch(GridGraph& graph, const MapPyramid& pyramid,
+                                     const Cell& start, const Cell& goal,
+                                     int corridor_radius, SearchFunction search)
+{
+    if (!isCellInBounds(start.i, start.j, graph) || !isCellInBounds(goal.i, goal.j, graph))
+    {
+        return std::vector<Cell>();
+    }
+
+    // Find the coarsest level where the start and goal are connected. Level 0
+    // is skipped since a corridor there would not restrict anything.
+    int level_idx = -1;
+    std::vector<Cell> coarse_path;
+    for (int l = pyramid.levels.size() - 1; l > 0; --l)
+    {
+        const MapLevel& level = pyramid.levels[l];
+        Cell coarse_start = {start.i / level.scale, start.j / level.scale};
+        Cell coarse_goal = {goal.i / level.scale, goal.j / level.scale};
+        coarse_path = searchLevel(level, coarse_start, coarse_goal);
+        if (coarse_path.size() > 0)
+        {
+            level_idx = l;
+            break;
+        }
+    }
+
+    std::vector<Cell> path;
+    if (level_idx > 0)
+    {
+        const MapLevel& level = pyramid.levels[level_idx];
+        int max_radius = std::max(level.width, level.height);
+        for (int radius = std::max(corridor_radius, 0); radius < max_radius;
+             radius = std::max(2 * radius, 1))
+        {
+            setCorridorMask(graph, level, coarse_path, radius);
+            path = search(graph, start, goal);
+            if (path.size() > 0 || isSearchCancelled(graph)) break;
+        }
+    }
+
+    graph.search_mask.clear();
+
+    // Fall back to searching the whole map.
+    if (path.size() == 0 && !isSearchCancelled(graph)) path = search(graph, start, goal);
+
+    return path;
+}
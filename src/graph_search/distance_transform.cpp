@@ -1,6 +1,8 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <algorithm>
 
 #include <path_planning/utils/math_helpers.h>
 #include <path_planning/utils/graph_utils.h>
@@ -9,14 +11,28 @@
 
 /**
  * These functions should calculate the distance transform on the given graph
- * and store it in graph.obstacle_distances.
+ * and store it in graph.obstacle_distances. They increment graph.dt_version
+ * so that anything built from the distance transform knows to update.
  *
  * This is part of the Distance Transform advanced extensions for Project 3.
  **/
 
 
+/**
+ * Allocates graph.obstacle_distances for a float distance transform and frees
+ * the integer one, so only one distance transform is kept in memory.
+ */
+static void initFloatDistances(GridGraph& graph)
+{
+    graph.obstacle_distances.assign(graph.width * graph.height, 0);
+    std::vector<uint16_t>().swap(graph.obstacle_sq_distances);
+}
+
+
 void distanceTransformSlow(GridGraph& graph)
 {
+    initFloatDistances(graph);
+
     /**
      * TODO (P3 - Practice for Advanced Extension): Perform a distance transform
      * by finding the distance to the nearest occupied cell for each unoccupied
@@ -25,17 +41,23 @@ void distanceTransformSlow(GridGraph& graph)
      *
      * Store the result in the vector graph.obstacle_distances.
      **/
+
+    graph.dt_version++;
 }
 
 
 void distanceTransformManhattan(GridGraph& graph)
 {
+    initFloatDistances(graph);
+
     /**
      * TODO (P3 - Advanced Extension): Perform a distance transform using the Manhattan distance
      * transform algorithm over a 2D grid.
      *
      * Store the result in the vector graph.obstacle_distances.
      **/
+
+    graph.dt_version++;
 }
 
 
@@ -57,6 +79,8 @@ std::vector<float> distanceTransformEuclidean1D(std::vector<float>& init_dt)
 
 void distanceTransformEuclidean2D(GridGraph& graph)
 {
+    initFloatDistances(graph);
+
     /**
      * TODO (P3 - Advanced Extension): Perform a distance transform using the
      * Euclidean distance transform algorithm over a 2D grid. Use the
@@ -64,4 +88,110 @@ void distanceTransformEuclidean2D(GridGraph& graph)
      *
      * Store the result in the vector graph.obstacle_distances.
      **/
+
+    graph.dt_version++;
+}
+
+
+/**
+ * Integer division rounding towards negative infinity.
+ */
+static inline int64_t floorDiv(int64_t num, int64_t den)
+{
+    int64_t q = num / den;
+    return (num % den != 0 && (num < 0) != (den < 0)) ? q - 1 : q;
+}
+
+
+void distanceTransformSquared(GridGraph& graph)
+{
+    int width = graph.width, height = graph.height;
+    const int64_t inf = width + height;  // Larger than any real distance.
+
+    // Phase 1: Distance to the nearest obstacle in the same column. Each pass
+    // updates a whole row from the previous one, so the inner loops run over
+    // contiguous memory.
+    std::vector<int32_t> col_dist(width * height);
+    for (int i = 0; i < width; ++i)
+    {
+        col_dist[i] = isIdxOccupied(i, graph) ? 0 : inf;
+    }
+    for (int j = 1; j < height; ++j)
+    {
+        const int32_t* prev = &col_dist[(j - 1) * width];
+        int32_t* cur = &col_dist[j * width];
+        const int8_t* odds = &graph.cell_odds[j * width];
+        for (int i = 0; i < width; ++i)
+        {
+            cur[i] = odds[i] >= graph.threshold ? 0 : std::min<int32_t>(prev[i] + 1, inf);
+        }
+    }
+    for (int j = height - 2; j >= 0; --j)
+    {
+        const int32_t* next = &col_dist[(j + 1) * width];
+        int32_t* cur = &col_dist[j * width];
+        for (int i = 0; i < width; ++i)
+        {
+            cur[i] = std::min(cur[i], next[i] + 1);
+        }
+    }
+
+    // Phase 2: Lower envelope of the parabolas f(x) = (x - u)^2 + g(u)^2 along
+    // each row.
+    graph.obstacle_sq_distances.resize(width * height);
+    std::vector<int> s(width), t(width);
+    std::vector<int64_t> g_sq(width);
+    for (int j = 0; j < height; ++j)
+    {
+        const int32_t* g = &col_dist[j * width];
+        for (int u = 0; u < width; ++u) g_sq[u] = int64_t(g[u]) * g[u];
+
+        // The first x where parabola u is below parabola i, for i < u.
+        auto sep = [&g_sq](int64_t i, int64_t u)
+        {
+            return floorDiv(u * u - i * i + g_sq[u] - g_sq[i], 2 * (u - i)) + 1;
+        };
+
+        int q = 0;
+        s[0] = 0;
+        t[0] = 0;
+        for (int u = 1; u < width; ++u)
+        {
+            while (q >= 0 && (t[q] - s[q]) * int64_t(t[q] - s[q]) + g_sq[s[q]] >
+                             (t[q] - u) * int64_t(t[q] - u) + g_sq[u])
+            {
+                q--;
+            }
+
+            if (q < 0)
+            {
+                q = 0;
+                s[0] = u;
+            }
+            else
+            {
+                int64_t w = sep(s[q], u);
+                if (w < width)
+                {
+                    q++;
+                    s[q] = u;
+                    t[q] = w;
+                }
+            }
+        }
+
+        uint16_t* out = &graph.obstacle_sq_distances[j * width];
+        for (int u = width - 1; u >= 0; --u)
+        {
+            int64_t dx = u - s[q];
+            out[u] = static_cast<uint16_t>(std::min<int64_t>(dx * dx + g_sq[s[q]], UINT16_MAX));
+            if (u == t[q]) q--;
+        }
+    }
+
+    // The float distance transform is not used once this one exists.
+    std::vector<float>().swap(graph.obstacle_distances);
+
+    updateCollisionThreshold(graph);
+    graph.dt_version++;
 }
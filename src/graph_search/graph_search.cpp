@@ -17,11 +17,12 @@
  * Next, implement the graph search function. Save the result in the path
  * variable defined for you.
  *
- * To visualize which cells are visited in the navigation webapp, save each
- * visited cell in the vector in the graph struct as follows:
- *      graph.visited_cells.push_back(c);
+ * To visualize which cells are visited in the navigation webapp, record each
+ * visited cell in the graph struct as follows:
+ *      recordVisited(c, graph);
  * where c is a Cell struct corresponding to the visited cell you want to
- * visualize.
+ * visualize. How (and whether) the cell is stored depends on
+ * graph.visited_policy, which can be set with setVisitedPolicy().
  *
  * The tracePath() function will return a path (which you should assign to
  * the path variable above) given the goal index, if you have kept track
@@ -0,0 +1,396 @@
+#include <iostream>
+#include <cmath>
+#include <queue>
+#include <functional>
+#include <algorithm>
+
+#include <path_planning/utils/math_helpers.h>
+#include <path_planning/utils/graph_utils.h>
+
+#include <path_planning/graph_search/node_store.h>
+#include <path_planning/graph_search/lattice_planner.h>
+
+
+std::vector<std::array<float, 2> > makeRectangleFootprint(float length, float width)
+{
+    float hl = length / 2, hw = width / 2;
+    return {{hl, -hw}, {hl, hw}, {-hl, hw}, {-hl, -hw}};
+}
+
+
+/**
+ * Checks whether the point is inside the polygon (even-odd rule).
+ */
+static bool pointInPolygon(float x, float y, const std::vector<std::array<float, 2> >& poly)
+{
+    bool inside = false;
+    for (int a = 0, b = poly.size() - 1; a < poly.size(); b = a++)
+    {
+        if ((poly[a][1] > y) != (poly[b][1] > y) &&
+            x < (poly[b][0] - poly[a][0]) * (y - poly[a][1]) / (poly[b][1] - poly[a][1]) + poly[a][0])
+        {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+
+/**
+ * Distance from the point to the nearest edge of the polygon.
+ */
+static float distanceToPolygon(float x, float y, const std::vector<std::array<float, 2> >& poly)
+{
+    float min_dist = HIGH;
+    for (int a = 0, b = poly.size() - 1; a < poly.size(); b = a++)
+    {
+        float ex = poly[a][0] - poly[b][0], ey = poly[a][1] - poly[b][1];
+        float len_sq = ex * ex + ey * ey;
+        float t = len_sq > 0 ? ((x - poly[b][0]) * ex + (y - poly[b][1]) * ey) / len_sq : 0;
+        t = std::max(0.0f, std::min(1.0f, t));
+        min_dist = std::min(min_dist, std::hypot(x - poly[b][0] - t * ex, y - poly[b][1] - t * ey));
+    }
+    return min_dist;
+}
+
+
+/**
+ * Builds the motion primitive that moves length cells from heading h while
+ * turning by dh headings. Returns false if the motion ends in the start cell.
+ */
+static bool makePrimitive(int h, int dh, float length, int num_headings, MotionPrimitive& prim)
+{
+    float dtheta = 2 * PI / num_headings;
+    float theta0 = h * dtheta, turn = dh * dtheta;
+
+    // Position along the ideal straight line or arc, t in [0, 1].
+    auto position = [&](float t, float& x, float& y)
+    {
+        if (dh == 0)
+        {
+            x = length * t * cos(theta0);
+            y = length * t * sin(theta0);
+        }
+        else
+        {
+            float radius = length / turn;
+            x = radius * (sin(theta0 + turn * t) - sin(theta0));
+            y = -radius * (cos(theta0 + turn * t) - cos(theta0));
+        }
+    };
+
+    float end_x, end_y;
+    position(1, end_x, end_y);
+    prim.di = static_cast<int>(std::round(end_x));
+    prim.dj = static_cast<int>(std::round(end_y));
+    if (prim.di == 0 && prim.dj == 0) return false;
+
+    prim.end_heading = ((h + dh) % num_headings + num_headings) % num_headings;
+    prim.cost = std::max(length, std::hypot(float(prim.di), float(prim.dj)));
+
+    // Sample every half cell, spreading the rounding error of the end cell
+    // along the motion so that the samples finish exactly on the end state.
+    prim.samples.clear();
+    int num_samples = std::max(1, static_cast<int>(std::ceil(2 * length)));
+    for (int s = 1; s <= num_samples; ++s)
+    {
+        float t = float(s) / num_samples, x, y;
+        position(t, x, y);
+        LatticeState sample;
+        sample.i = static_cast<int>(std::round(x + t * (prim.di - end_x)));
+        sample.j = static_cast<int>(std::round(y + t * (prim.dj - end_y)));
+        int heading = static_cast<int>(std::round((theta0 + turn * t) / dtheta));
+        sample.heading = (heading % num_headings + num_headings) % num_headings;
+
+        if (prim.samples.empty() || prim.samples.back().i != sample.i ||
+            prim.samples.back().j != sample.j || prim.samples.back().heading != sample.heading)
+        {
+            prim.samples.push_back(sample);
+        }
+    }
+    prim.samples.back() = {prim.di, prim.dj, prim.end_heading};
+
+    return true;
+}
+
+
+void initLattice(const GridGraph& graph, const std::vector<std::array<float, 2> >& footprint,
+                 Lattice& lattice, int num_headings, float step_length, float turn_cost)
+{
+    lattice.num_headings = num_headings;
+    lattice.masks.assign(num_headings, std::vector<std::array<int, 2> >());
+    lattice.primitives.assign(num_headings, std::vector<MotionPrimitive>());
+    lattice.free_sq_dist = 0;
+    lattice.extent = 0;
+
+    // Rasterize the rotated footprint. A cell is covered if its center is
+    // inside the polygon or within half a cell of its boundary.
+    float max_radius = 0;
+    for (auto& v : footprint) max_radius = std::max(max_radius, std::hypot(v[0], v[1]));
+    int bound = static_cast<int>(std::ceil(max_radius / graph.meters_per_cell)) + 1;
+
+    for (int h = 0; h < num_headings; ++h)
+    {
+        float c = std::cos(2 * PI * h / num_headings), s = std::sin(2 * PI * h / num_headings);
+        std::vector<std::array<float, 2> > poly;
+        for (auto& v : footprint)
+        {
+            poly.push_back({(v[0] * c - v[1] * s) / graph.meters_per_cell,
+                            (v[0] * s + v[1] * c) / graph.meters_per_cell});
+        }
+
+        for (int dj = -bound; dj <= bound; ++dj)
+        {
+            for (int di = -bound; di <= bound; ++di)
+            {
+                if (pointInPolygon(di, dj, poly) || distanceToPolygon(di, dj, poly) <= 0.5)
+                {
+                    lattice.masks[h].push_back({di, dj});
+                    lattice.free_sq_dist = std::max(lattice.free_sq_dist, float(di * di + dj * dj));
+                    lattice.extent = std::max(lattice.extent, std::max(std::abs(di), std::abs(dj)));
+                }
+            }
+        }
+    }
+
+    // Find the largest disk of offsets covered by every mask. An obstacle
+    // inside this disk is a collision at any heading.
+    std::vector<int> coverage((2 * bound + 1) * (2 * bound + 1), 0);
+    for (auto& mask : lattice.masks)
+    {
+        for (auto& offset : mask) coverage[(offset[1] + bound) * (2 * bound + 1) + offset[0] + bound]++;
+    }
+    int first_uncovered = (2 * bound + 1) * (2 * bound + 1);
+    for (int dj = -bound; dj <= bound; ++dj)
+    {
+        for (int di = -bound; di <= bound; ++di)
+        {
+            if (coverage[(dj + bound) * (2 * bound + 1) + di + bound] < num_headings)
+            {
+                first_uncovered = std::min(first_uncovered, di * di + dj * dj);
+            }
+        }
+    }
+    lattice.blocked_sq_dist = first_uncovered - 1;
+
+    // Motion primitives: long straight and arc moves, a short straight move to
+    // reach every cell, and turns in place.
+    for (int h = 0; h < num_headings; ++h)
+    {
+        MotionPrimitive prim;
+        if (makePrimitive(h, 0, step_length, num_headings, prim)) lattice.primitives[h].push_back(prim);
+        if (makePrimitive(h, 1, step_length, num_headings, prim)) lattice.primitives[h].push_back(prim);
+        if (makePrimitive(h, -1, step_length, num_headings, prim)) lattice.primitives[h].push_back(prim);
+
+        // Short moves go to the nearest 8-connected neighbor in the heading direction.
+        float theta = 2 * PI * h / num_headings;
+        float short_length = std::abs(std::round(cos(theta))) + std::abs(std::round(sin(theta))) > 1 ? M_SQRT2 : 1;
+        if (makePrimitive(h, 0, short_length, num_headings, prim)) lattice.primitives[h].push_back(prim);
+
+        for (int dh = -1; dh <= 1; dh += 2)
+        {
+            prim.di = 0;
+            prim.dj = 0;
+            prim.end_heading = (h + dh + num_headings) % num_headings;
+            prim.cost = turn_cost;
+            prim.samples = {{0, 0, prim.end_heading}};
+            lattice.primitives[h].push_back(prim);
+        }
+    }
+}
+
+
+/**
+ * Squared distance in cells from the cell to the nearest obstacle, from
+ * whichever distance transform has been computed, or -1 if there is none.
+ */
+static inline float obstacleSqDistance(int idx, const GridGraph& graph)
+{
+    if (!graph.obstacle_sq_distances.empty()) return graph.obstacle_sq_distances[idx];
+    if (graph.obstacle_distances.empty()) return -1;
+    return graph.obstacle_distances[idx] * graph.obstacle_distances[idx];
+}
+
+
+bool checkFootprintCollision(const LatticeState& state, const GridGraph& graph, const Lattice& lattice)
+{
+    if (!isCellInBounds(state.i, state.j, graph)) return true;
+
+    float sq_dist = obstacleSqDistance(cellToIdx(state.i, state.j, graph), graph);
+    bool inside_map = state.i - lattice.extent >= 0 && state.j - lattice.extent >= 0 &&
+                      state.i + lattice.extent < graph.width && state.j + lattice.extent < graph.height;
+
+    if (sq_dist >= 0)
+    {
+        if (sq_dist > lattice.free_sq_dist && inside_map) return false;
+        if (sq_dist <= lattice.blocked_sq_dist) return true;
+    }
+
+    // Close to an obstacle, near the edge of the map or without a distance
+    // transform, so check the whole mask.
+    for (auto& offset : lattice.masks[state.heading])
+    {
+        int i = state.i + offset[0], j = state.j + offset[1];
+        if (!isCellInBounds(i, j, graph) || isCellOccupied(i, j, graph)) return true;
+    }
+
+    return false;
+}
+
+
+std::vector<LatticeState> latticeSearch(GridGraph& graph, const Lattice& lattice,
+                                        const LatticeState& start, const Cell& goal)
+{
+    return latticeSearch(graph, graph, lattice, start, goal);
+}
+
+
+std::vector<LatticeState> latticeSearch(const GridGraph& graph, SearchScratch& scratch, const Lattice& lattice,
+                                        const LatticeState& start, const Cell& goal)
+{
+    std::vector<LatticeState> path;
+
+    initSearchScratch(graph, scratch);  // Make sure the visited cells are reset.
+
+    if (!isCellInBounds(goal.i, goal.j, graph) || checkFootprintCollision(start, graph, lattice))
+    {
+        return path;
+    }
+
+    const int num_headings = lattice.num_headings;
+    auto stateToIdx = [&](const LatticeState& s) { return cellToIdx(s.i, s.j, graph) * num_headings + s.heading; };
+    auto idxToState = [&](int idx)
+    {
+        Cell c = idxToCell(idx / num_headings, graph);
+        return LatticeState{c.i, c.j, idx % num_headings};
+    };
+    auto heuristic = [&](int i, int j) { return std::hypot(float(goal.i - i), float(goal.j - j)); };
+
+    // Node data is keyed by state index. The data field holds the primitive
+    // used to reach the state from its parent.
+    NodeStore nodes;
+    initNodeStore(nodes, graph, int64_t(graph.width) * graph.height * num_headings,
+                  estimateSearchNodes(graph, {start.i, start.j}, goal) * num_headings);
+
+    typedef std::pair<float, int> QueueItem;  // Estimated total cost, state index.
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > open;
+
+    int start_idx = stateToIdx(start);
+    getNode(nodes, start_idx)->cost = 0;
+    open.push({heuristic(start.i, start.j), start_idx});
+
+    int goal_idx = -1;
+    int expansions = 0;
+    while (!open.empty() && goal_idx < 0)
+    {
+        if (++expansions % SEARCH_CANCEL_INTERVAL == 0 && isSearchCancelled(scratch)) return path;
+
+        int idx = open.top().second;
+        open.pop();
+
+        NodeRecord* node = findNode(nodes, idx);
+        if (node->closed) continue;  // Stale queue entry.
+        node->closed = true;
+        float cost = node->cost;
+
+        LatticeState s = idxToState(idx);
+        if (s.i == goal.i && s.j == goal.j)
+        {
+            goal_idx = idx;
+            break;
+        }
+        recordVisited({s.i, s.j}, graph, scratch);
+
+        const std::vector<MotionPrimitive>& prims = lattice.primitives[s.heading];
+        for (int p = 0; p < int(prims.size()); ++p)
+        {
+            bool valid = true;
+            for (const LatticeState& sample : prims[p].samples)
+            {
+                if (checkFootprintCollision({s.i + sample.i, s.j + sample.j, sample.heading}, graph, lattice))
+                {
+                    valid = false;
+                    break;
+                }
+            }
+            if (!valid) continue;
+
+            LatticeState next = {s.i + prims[p].di, s.j + prims[p].dj, prims[p].end_heading};
+            int next_idx = stateToIdx(next);
+            float next_cost = cost + prims[p].cost;
+
+            NodeRecord* next_node = getNode(nodes, next_idx);
+            if (next_node == nullptr)
+            {
+                std::cerr << "ERROR: latticeSearch: Node memory cap of "
+                          << (nodes.memory_cap >> 20) << " MB reached." << std::endl;
+                scratch.search_status = SEARCH_MEMORY_CAP;
+                return path;
+            }
+            if (next_node->closed || next_node->cost <= next_cost) continue;
+
+            *next_node = {next_cost, idx, p, false};
+            open.push({next_cost + heuristic(next.i, next.j), next_idx});
+        }
+    }
+
+    if (goal_idx < 0) return path;
+
+    // Walk back to the start, adding the swept samples of each primitive.
+    for (int idx = goal_idx; findNode(nodes, idx)->parent >= 0; idx = findNode(nodes, idx)->parent)
+    {
+        NodeRecord* node = findNode(nodes, idx);
+        LatticeState parent = idxToState(node->parent);
+        const MotionPrimitive& prim = lattice.primitives[parent.heading][node->data];
+        for (int k = int(prim.samples.size()) - 1; k >= 0; --k)
+        {
+            path.push_back({parent.i + prim.samples[k].i, parent.j + prim.samples[k].j, prim.samples[k].heading});
+        }
+    }
+    path.push_back(start);
+    std::reverse(path.begin(), path.end());
+
+    return path;
+}
+
+
+bool isValidLatticePath(const std::vector<LatticeState>& path, const LatticeState& start, const Cell& goal,
+                        const GridGraph& graph, const Lattice& lattice)
+{
+    if (path.size() == 0) return false;
+    if (path.front().i != start.i || path.front().j != start.j) return false;
+    if (path.back().i != goal.i || path.back().j != goal.j) return false;
+
+    for (size_t k = 0; k < path.size(); ++k)
+    {
+        const LatticeState& s = path[k];
+        if (s.heading < 0 || s.heading >= lattice.num_headings) return false;
+        if (k > 0 && (std::abs(s.i - path[k - 1].i) > 1 || std::abs(s.j - path[k - 1].j) > 1)) return false;
+        if (checkFootprintCollision(s, graph, lattice)) return false;
+    }
+    return true;
+}
+
+
+std::vector<Cell> latticePathToCells(const std::vector<LatticeState>& path)
+{
+    std::vector<Cell> cells;
+    for (const LatticeState& s : path)
+    {
+        if (cells.empty() || cells.back().i != s.i || cells.back().j != s.j) cells.push_back({s.i, s.j});
+    }
+    return cells;
+}
+
+
+std::vector<std::array<float, 3> > latticePathToPoses(const std::vector<LatticeState>& path,
+                                                      const Lattice& lattice, const GridGraph& graph)
+{
+    std::vector<std::array<float, 3> > poses;
+    for (const LatticeState& s : path)
+    {
+        auto position = cellToPos(s.i, s.j, graph);
+        poses.push_back({position[0], position[1], normalizeAngle(2 * PI * s.heading / lattice.num_headings)});
+    }
+    return poses;
+}
@@ -0,0 +1,546 @@
+#include <cmath>
+#include <queue>
+#include <limits>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/utils/query_trace.h>
+
+#include <path_planning/graph_search/node_store.h>
+#include <path_planning/graph_search/multi_agent.h>
+
+#define EMPTY_KEY (~uint64_t(0))
+
+
+static const int MOVE_DI[4] = {1, -1, 0, 0};
+static const int MOVE_DJ[4] = {0, 0, 1, -1};
+
+
+static inline size_t keySlot(uint64_t key, size_t num_slots)
+{
+    return ((key * 0x9E3779B97F4A7C15ULL) >> 32) & (num_slots - 1);
+}
+
+
+static bool containsKey(const std::vector<uint64_t>& keys, uint64_t key)
+{
+    for (size_t slot = keySlot(key, keys.size()); ; slot = (slot + 1) & (keys.size() - 1))
+    {
+        if (keys[slot] == key) return true;
+        if (keys[slot] == EMPTY_KEY) return false;
+    }
+}
+
+
+static void insertKey(std::vector<uint64_t>& keys, size_t& count, uint64_t key)
+{
+    // Keep the set at most half full so probe sequences stay short.
+    if (2 * (count + 1) > keys.size())
+    {
+        std::vector<uint64_t> old_keys(keys.size() * 2, EMPTY_KEY);
+        old_keys.swap(keys);
+        for (uint64_t k : old_keys)
+        {
+            if (k == EMPTY_KEY) continue;
+            size_t slot = keySlot(k, keys.size());
+            while (keys[slot] != EMPTY_KEY) slot = (slot + 1) & (keys.size() - 1);
+            keys[slot] = k;
+        }
+    }
+
+    size_t slot = keySlot(key, keys.size());
+    for (; keys[slot] != EMPTY_KEY; slot = (slot + 1) & (keys.size() - 1))
+    {
+        if (keys[slot] == key) return;
+    }
+    keys[slot] = key;
+    count++;
+}
+
+
+/**
+ * Adds the bits to the reserved cells of the (time, block) key.
+ */
+static void reserveBlock(ReservationTable& table, uint64_t key, uint64_t bits)
+{
+    std::vector<uint64_t>& keys = table.block_keys;
+    size_t slot = keySlot(key, keys.size());
+    for (; keys[slot] != EMPTY_KEY; slot = (slot + 1) & (keys.size() - 1))
+    {
+        if (keys[slot] == key)
+        {
+            table.block_bits[slot] |= bits;
+            return;
+        }
+    }
+
+    // The key is new. Keep the table at most half full so probe sequences
+    // stay short, and find the empty slot again if it grew.
+    if (2 * (table.num_blocks + 1) > keys.size())
+    {
+        std::vector<uint64_t> old_keys(keys.size() * 2, EMPTY_KEY), old_bits(keys.size() * 2, 0);
+        old_keys.swap(keys);
+        old_bits.swap(table.block_bits);
+        for (size_t old_slot = 0; old_slot < old_keys.size(); ++old_slot)
+        {
+            if (old_keys[old_slot] == EMPTY_KEY) continue;
+            size_t new_slot = keySlot(old_keys[old_slot], keys.size());
+            while (keys[new_slot] != EMPTY_KEY) new_slot = (new_slot + 1) & (keys.size() - 1);
+            keys[new_slot] = old_keys[old_slot];
+            table.block_bits[new_slot] = old_bits[old_slot];
+        }
+
+        slot = keySlot(key, keys.size());
+        while (keys[slot] != EMPTY_KEY) slot = (slot + 1) & (keys.size() - 1);
+    }
+
+    keys[slot] = key;
+    table.block_bits[slot] = bits;
+    table.num_blocks++;
+}
+
+
+static inline uint64_t blockKey(int t, int block)
+{
+    return (uint64_t(t) << 32) | uint32_t(block);
+}
+
+
+static inline uint64_t edgeKey(int t, int from_idx, int dir)
+{
+    return (((uint64_t(t) << 32) | uint32_t(from_idx)) << 2) | dir;
+}
+
+
+void initReservationTable(ReservationTable& table, int separation, const GridGraph& graph)
+{
+    table.block_keys.assign(1024, EMPTY_KEY);
+    table.block_bits.assign(1024, 0);
+    table.edge_keys.assign(1024, EMPTY_KEY);
+    table.num_blocks = 0;
+    table.num_edges = 0;
+    table.hold_times.clear();
+    table.wait_counts.clear();
+    table.width = graph.width;
+    table.blocks_wide = ((graph.width - 1) >> RESERVATION_BLOCK_BITS) + 1;
+    table.horizon = 0;
+    table.separation = std::max(separation, 0);
+}
+
+
+void reserveCell(ReservationTable& table, int t, int idx, const GridGraph& graph)
+{
+    // Reserve every cell within the separation distance, so lookups only need
+    // to check one bit. The disk is built one block at a time.
+    const int block_size = 1 << RESERVATION_BLOCK_BITS;
+    Cell c = idxToCell(idx, graph);
+    int sep = table.separation;
+    int first_bi = std::max(c.i - sep, 0) >> RESERVATION_BLOCK_BITS;
+    int last_bi = std::min(c.i + sep, graph.width - 1) >> RESERVATION_BLOCK_BITS;
+    int first_bj = std::max(c.j - sep, 0) >> RESERVATION_BLOCK_BITS;
+    int last_bj = std::min(c.j + sep, graph.height - 1) >> RESERVATION_BLOCK_BITS;
+    for (int bj = first_bj; bj <= last_bj; ++bj)
+    {
+        for (int bi = first_bi; bi <= last_bi; ++bi)
+        {
+            uint64_t bits = 0;
+            for (int y = 0; y < block_size; ++y)
+            {
+                int dj = bj * block_size + y - c.j;
+                for (int x = 0; x < block_size; ++x)
+                {
+                    int di = bi * block_size + x - c.i;
+                    if (di * di + dj * dj <= sep * sep) bits |= uint64_t(1) << (x + y * block_size);
+                }
+            }
+            if (bits != 0) reserveBlock(table, blockKey(t, bi + bj * table.blocks_wide), bits);
+        }
+    }
+    table.horizon = std::max(table.horizon, t);
+}
+
+
+void holdCell(ReservationTable& table, int t, int idx, const GridGraph& graph)
+{
+    if (table.hold_times.empty())
+    {
+        table.hold_times.assign(graph.width * graph.height, std::numeric_limits<int>::max());
+    }
+
+    Cell c = idxToCell(idx, graph);
+    int sep = table.separation;
+    for (int dj = -sep; dj <= sep; ++dj)
+    {
+        for (int di = -sep; di <= sep; ++di)
+        {
+            if (di * di + dj * dj > sep * sep || !isCellInBounds(c.i + di, c.j + dj, graph)) continue;
+            int& hold_time = table.hold_times[cellToIdx(c.i + di, c.j + dj, graph)];
+            hold_time = std::min(hold_time, t);
+        }
+    }
+    table.horizon = std::max(table.horizon, t);
+}
+
+
+/**
+ * Adds change to the wait count of the cells within the separation distance of the cell.
+ */
+static void changeWaitCounts(ReservationTable& table, int idx, int change, const GridGraph& graph)
+{
+    if (table.wait_counts.empty()) table.wait_counts.assign(graph.width * graph.height, 0);
+
+    Cell c = idxToCell(idx, graph);
+    int sep = table.separation;
+    for (int dj = -sep; dj <= sep; ++dj)
+    {
+        for (int di = -sep; di <= sep; ++di)
+        {
+            if (di * di + dj * dj > sep * sep || !isCellInBounds(c.i + di, c.j + dj, graph)) continue;
+            table.wait_counts[cellToIdx(c.i + di, c.j + dj, graph)] += change;
+        }
+    }
+}
+
+
+void addWaitingRobot(ReservationTable& table, int idx, const GridGraph& graph)
+{
+    changeWaitCounts(table, idx, 1, graph);
+}
+
+
+void removeWaitingRobot(ReservationTable& table, int idx, const GridGraph& graph)
+{
+    changeWaitCounts(table, idx, -1, graph);
+}
+
+
+bool isCellReserved(const ReservationTable& table, int t, int idx)
+{
+    if (!table.hold_times.empty() && table.hold_times[idx] <= t) return true;
+    if (!table.wait_counts.empty() && table.wait_counts[idx] > 0) return true;
+
+    const int block_mask = (1 << RESERVATION_BLOCK_BITS) - 1;
+    int i = idx % table.width, j = idx / table.width;
+    uint64_t key = blockKey(t, (i >> RESERVATION_BLOCK_BITS) + (j >> RESERVATION_BLOCK_BITS) * table.blocks_wide);
+    const std::vector<uint64_t>& keys = table.block_keys;
+    for (size_t slot = keySlot(key, keys.size()); ; slot = (slot + 1) & (keys.size() - 1))
+    {
+        if (keys[slot] == key)
+        {
+            return (table.block_bits[slot] >> ((i & block_mask) + ((j & block_mask) << RESERVATION_BLOCK_BITS))) & 1;
+        }
+        if (keys[slot] == EMPTY_KEY) return false;
+    }
+}
+
+
+/**
+ * Reserves a planned path, including the robot waiting at its goal forever.
+ */
+static void reservePath(ReservationTable& table, const std::vector<Cell>& path, const GridGraph& graph)
+{
+    for (size_t t = 0; t < path.size(); ++t)
+    {
+        int idx = cellToIdx(path[t].i, path[t].j, graph);
+        reserveCell(table, t, idx, graph);
+
+        // Without a separation distance, robots could swap cells in one step.
+        if (table.separation == 0 && t + 1 < path.size())
+        {
+            for (int dir = 0; dir < 4; ++dir)
+            {
+                if (path[t].i + MOVE_DI[dir] == path[t + 1].i && path[t].j + MOVE_DJ[dir] == path[t + 1].j)
+                {
+                    insertKey(table.edge_keys, table.num_edges, edgeKey(t, idx, dir));
+                }
+            }
+        }
+    }
+
+    const Cell& goal = path.back();
+    holdCell(table, path.size() - 1, cellToIdx(goal.i, goal.j, graph), graph);
+}
+
+
+std::vector<Cell> spaceTimeSearch(const GridGraph& graph, const ReservationTable& table,
+                                  const AgentQuery& query, int max_time, uint64_t deadline, SearchStatus* status)
+{
+    std::vector<Cell> path;
+    if (status != nullptr) *status = SEARCH_DONE;
+
+    const Cell& start = query.start;
+    const Cell& goal = query.goal;
+    if (!isCellInBounds(start.i, start.j, graph) || !isCellInBounds(goal.i, goal.j, graph))
+    {
+        return path;
+    }
+
+    int start_idx = cellToIdx(start.i, start.j, graph);
+    int goal_idx = cellToIdx(goal.i, goal.j, graph);
+    if (checkCollisionFast(start_idx, graph) || checkCollisionFast(goal_idx, graph)) return path;
+
+    // States are keyed by time * num_cells + cell. After the last reservation
+    // nothing changes, so those times share a key and waiting is pointless.
+    int64_t num_cells = int64_t(graph.width) * graph.height;
+    int last_time = std::min(table.horizon + 1, max_time);
+    auto stateKey = [&](int t, int idx) { return std::min(t, last_time) * num_cells + idx; };
+
+    // The heuristic is the distance to the goal ignoring other robots, from a
+    // breadth first search out from the goal. Detours around other robots
+    // rarely go far, so the search only covers the cells whose distance from
+    // the goal plus Manhattan distance to the start is within a bound, an
+    // ellipse around the two. It reads the integer distance transform directly
+    // when checkCollisionFast() would do the same, since it covers many cells.
+    // Cells in collision are marked -2 so they are only checked once.
+    bool direct_dt = !graph.obstacle_sq_distances.empty() && graph.search_mask.empty();
+    auto blocked = [&](int idx)
+    {
+        return direct_dt ? graph.obstacle_sq_distances[idx] <= graph.collision_sq_threshold
+                         : checkCollisionFast(idx, graph);
+    };
+    auto startDist = [&](int i, int j) { return std::abs(i - start.i) + std::abs(j - start.j); };
+
+    std::vector<int> goal_dist(num_cells);
+    std::vector<int> frontier;
+    int min_dist = startDist(goal.i, goal.j);
+    int bound = min_dist + min_dist / 4 + 16;
+    bool pruned = true;
+    while (true)
+    {
+        std::fill(goal_dist.begin(), goal_dist.end(), -1);
+        frontier.assign(1, goal_idx);
+        goal_dist[goal_idx] = 0;
+        pruned = false;
+        for (size_t head = 0; head < frontier.size(); ++head)
+        {
+            int idx = frontier[head];
+            int j = idx / graph.width, i = idx - j * graph.width;
+            int n_i[4] = {i + 1, i - 1, i, i}, n_j[4] = {j, j, j + 1, j - 1};
+            for (int n = 0; n < 4; ++n)
+            {
+                if (n_i[n] < 0 || n_j[n] < 0 || n_i[n] >= graph.width || n_j[n] >= graph.height) continue;
+
+                int n_idx = n_i[n] + n_j[n] * graph.width;
+                if (goal_dist[n_idx] != -1) continue;
+                if (blocked(n_idx))
+                {
+                    goal_dist[n_idx] = -2;
+                    continue;
+                }
+
+                goal_dist[n_idx] = goal_dist[idx] + 1;
+                if (goal_dist[n_idx] + startDist(n_i[n], n_j[n]) > bound) pruned = true;
+                else frontier.push_back(n_idx);
+            }
+        }
+
+        // Without pruning, every cell the goal can be reached from was found.
+        // Otherwise, the start is further than the bound, so try again with a
+        // larger one.
+        if (goal_dist[start_idx] >= 0 || !pruned || bound > max_time) break;
+        bound = 2 * bound;
+    }
+
+    if (goal_dist[start_idx] < 0 || goal_dist[start_idx] > max_time) return path;
+    bool reached_all = !pruned;
+
+    // The robot stays at its goal once it arrives, so it can't arrive before
+    // the last reservation of the goal, and never if the goal is held. Adding
+    // that wait to the heuristic keeps the search from trying every way to
+    // arrive early.
+    if (isCellReserved(table, table.horizon + 1, goal_idx)) return path;
+    int goal_free_time = 0;
+    for (int t = table.horizon; t >= 0 && goal_free_time == 0; --t)
+    {
+        if (isCellReserved(table, t, goal_idx)) goal_free_time = t + 1;
+    }
+    // Distances are exact inside the bound. Cells outside it are further from
+    // the goal than the bound allows, and than their Manhattan distance.
+    auto distance = [&](int idx)
+    {
+        int j = idx / graph.width, i = idx - j * graph.width;
+        int d = goal_dist[idx];
+        if (d >= 0 && d + startDist(i, j) <= bound) return d;
+        return std::max(std::abs(i - goal.i) + std::abs(j - goal.j), bound + 1 - startDist(i, j));
+    };
+    auto heuristic = [&](int t, int idx) { return std::max(distance(idx), goal_free_time - t); };
+
+    // With the exact distance heuristic, most states expanded are near the
+    // shortest path, plus detours and waits around other robots.
+    NodeStore nodes;
+    initNodeStore(nodes, graph, (last_time + 1) * num_cells, 64 * int64_t(goal_dist[start_idx] + 1));
+
+    // Many states tie on time plus heuristic, so break ties towards later
+    // times, which are closer to the goal. Keys don't fit in the parent field
+    // of the node records, so nodes keep their parent's cell and the parent
+    // key is found from the node's time.
+    typedef std::pair<int64_t, int64_t> QueueItem;  // (Time plus heuristic, minus time), state key.
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > open;
+    auto priority = [&](int t, int idx) { return (int64_t(t + heuristic(t, idx)) << 32) + distance(idx); };
+
+    NodeRecord* start_node = getNode(nodes, stateKey(0, start_idx));
+    *start_node = {0, -1, start_idx, false};
+    open.push({priority(0, start_idx), stateKey(0, start_idx)});
+
+    int64_t goal_key = -1;
+    int expansions = 0;
+    while (!open.empty() && goal_key < 0)
+    {
+        int64_t key = open.top().second;
+        open.pop();
+
+        NodeRecord* node = findNode(nodes, key);
+        if (node->closed) continue;  // Stale queue entry.
+        node->closed = true;
+        int t = static_cast<int>(node->cost);
+        int idx = node->data;
+
+        if (++expansions % 1024 == 0 && traceTimeMicro() > deadline) return path;
+
+        // The robot stays at its goal, so the goal must never be reserved again.
+        if (idx == goal_idx && t >= goal_free_time)
+        {
+            goal_key = key;
+            break;
+        }
+
+        if (t + heuristic(t, idx) >= max_time) continue;
+
+        Cell c = idxToCell(idx, graph);
+        for (int dir = 0; dir < 5; ++dir)
+        {
+            int n_idx = idx;  // Direction 4 waits in place.
+            if (dir < 4)
+            {
+                int ni = c.i + MOVE_DI[dir], nj = c.j + MOVE_DJ[dir];
+                if (!isCellInBounds(ni, nj, graph)) continue;
+                n_idx = cellToIdx(ni, nj, graph);
+                if (goal_dist[n_idx] == -2) continue;  // In collision.
+                if (goal_dist[n_idx] == -1 && (reached_all || blocked(n_idx))) continue;
+
+                // Don't swap cells with a robot moving the other way.
+                if (table.separation == 0 && containsKey(table.edge_keys, edgeKey(t, n_idx, dir ^ 1)))
+                {
+                    continue;
+                }
+            }
+            else if (t >= last_time)
+            {
+                continue;
+            }
+
+            if (isCellReserved(table, t + 1, n_idx)) continue;
+
+            NodeRecord* next = getNode(nodes, stateKey(t + 1, n_idx));
+            if (next == nullptr)
+            {
+                std::cerr << "ERROR: spaceTimeSearch: Node memory cap of "
+                          << (nodes.memory_cap >> 20) << " MB reached." << std::endl;
+                if (status != nullptr) *status = SEARCH_MEMORY_CAP;
+                return path;
+            }
+            if (next->closed || next->cost <= t + 1) continue;
+
+            *next = {float(t + 1), idx, n_idx, false};
+            open.push({priority(t + 1, n_idx), stateKey(t + 1, n_idx)});
+        }
+    }
+
+    if (goal_key < 0) return path;
+
+    for (int64_t key = goal_key; ; )
+    {
+        NodeRecord* node = findNode(nodes, key);
+        path.push_back(idxToCell(node->data, graph));
+        if (node->parent < 0) break;
+        key = stateKey(static_cast<int>(node->cost) - 1, node->parent);
+    }
+    std::reverse(path.begin(), path.end());
+
+    return path;
+}
+
+
+MultiAgentResult prioritizedPlan(const GridGraph& graph, const std::vector<AgentQuery>& agents,
+                                 const MultiAgentOptions& options)
+{
+    MultiAgentResult result;
+    result.paths.resize(agents.size());
+    result.num_planned = 0;
+    result.over_budget = false;
+    result.memory_capped = false;
+
+    int separation = options.separation;
+    if (separation < 0)
+    {
+        separation = static_cast<int>(std::ceil(2 * graph.collision_radius / graph.meters_per_cell));
+    }
+
+    int max_time = options.max_time < 0 ? 2 * (graph.width + graph.height) : options.max_time;
+
+    ReservationTable table;
+    initReservationTable(table, separation, graph);
+
+    // Every robot waits at its start until it is planned. Reserving the starts
+    // up front keeps the robots planned earlier clear of the ones which end up
+    // without a path, so no planned path needs dropping later.
+    int num_agents = agents.size();
+    std::vector<int> start_idx(num_agents, -1);
+    for (int a = 0; a < num_agents; ++a)
+    {
+        const Cell& start = agents[a].start;
+        if (!isCellInBounds(start.i, start.j, graph)) continue;
+        start_idx[a] = cellToIdx(start.i, start.j, graph);
+        addWaitingRobot(table, start_idx[a], graph);
+    }
+
+    // A robot which found no path may find one once the robots after it have
+    // left their starts, so retry those while each pass plans some robot.
+    uint64_t deadline = traceTimeMicro() + static_cast<uint64_t>(options.time_budget_ms * 1000);
+    bool planned_any = true;
+    while (planned_any && !result.over_budget)
+    {
+        planned_any = false;
+        int num_left = 0;
+        for (int a = 0; a < num_agents; ++a)
+        {
+            if (start_idx[a] >= 0 && result.paths[a].empty()) num_left++;
+        }
+
+        for (int a = 0; a < num_agents; ++a)
+        {
+            if (start_idx[a] < 0 || result.paths[a].size() > 0) continue;
+            if (traceTimeMicro() > deadline)
+            {
+                result.over_budget = true;
+                break;
+            }
+
+            // Give each robot up to twice its share of the remaining time, so
+            // one robot which can't reach its goal doesn't use up the whole
+            // budget. The robot's own start isn't in its way.
+            uint64_t now = traceTimeMicro();
+            uint64_t agent_deadline = std::min(deadline, now + 2 * (deadline - now) / num_left--);
+            SearchStatus status;
+            removeWaitingRobot(table, start_idx[a], graph);
+            result.paths[a] = spaceTimeSearch(graph, table, agents[a], max_time, agent_deadline, &status);
+            if (status == SEARCH_MEMORY_CAP) result.memory_capped = true;
+            if (result.paths[a].size() > 0)
+            {
+                reservePath(table, result.paths[a], graph);
+                result.num_planned++;
+                planned_any = true;
+            }
+            else
+            {
+                addWaitingRobot(table, start_idx[a], graph);
+            }
+        }
+    }
+
+    if (traceTimeMicro() > deadline) result.over_budget = true;
+
+    return result;
+}
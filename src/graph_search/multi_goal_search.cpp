@@ -0,0 +1,127 @@
+#include <cmath>
+#include <iostream>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+
+#include <path_planning/utils/math_helpers.h>
+#include <path_planning/utils/graph_utils.h>
+
+#include <path_planning/graph_search/node_store.h>
+#include <path_planning/graph_search/multi_goal_search.h>
+
+
+std::vector<GoalResult> nearestGoalsSearch(GridGraph& graph, const Cell& start,
+                                           const std::vector<Cell>& goals, int k)
+{
+    std::vector<GoalResult> results;
+
+    initGraph(graph);  // Make sure the visited cells are reset.
+
+    if (!isCellInBounds(start.i, start.j, graph) || k < 1) return results;
+
+    // Map each goal index to the goal cell. Duplicate goals are only counted once.
+    std::unordered_map<int, Cell> goal_cells;
+    for (const Cell& g : goals)
+    {
+        if (isCellInBounds(g.i, g.j, graph)) goal_cells[cellToIdx(g.i, g.j, graph)] = g;
+    }
+    if (goal_cells.empty()) return results;
+
+    // Per search node data. Costs are in cells. The search may need to reach
+    // the furthest goal, so size the store for that.
+    int64_t expected_nodes = 0;
+    for (auto& goal : goal_cells)
+    {
+        expected_nodes = std::max(expected_nodes, estimateSearchNodes(graph, start, goal.second));
+    }
+    NodeStore nodes;
+    initNodeStore(nodes, graph, int64_t(graph.width) * graph.height, expected_nodes);
+
+    typedef std::pair<float, int> QueueItem;  // Cost, index.
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > open;
+
+    int start_idx = cellToIdx(start.i, start.j, graph);
+    getNode(nodes, start_idx)->cost = 0;
+    open.push({0, start_idx});
+
+    const int di[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    const int dj[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+    while (!open.empty() && results.size() < size_t(k))
+    {
+        QueueItem item = open.top();
+        open.pop();
+
+        int idx = item.second;
+        NodeRecord* node = findNode(nodes, idx);
+        if (node->closed) continue;  // Stale queue entry.
+        node->closed = true;
+        float cost = node->cost;
+
+        Cell c = idxToCell(idx, graph);
+        recordVisited(c, graph);
+
+        // The first time a goal is closed its cost is optimal.
+        auto goal_it = goal_cells.find(idx);
+        if (goal_it != goal_cells.end())
+        {
+            GoalResult result;
+            result.goal = goal_it->second;
+            result.cost = cost;
+            for (int cur = idx; cur >= 0; cur = findNode(nodes, cur)->parent)
+            {
+                result.path.push_back(idxToCell(cur, graph));
+            }
+            std::reverse(result.path.begin(), result.path.end());
+            results.push_back(result);
+        }
+
+        for (int n = 0; n < 8; ++n)
+        {
+            int ni = c.i + di[n], nj = c.j + dj[n];
+            if (!isCellInBounds(ni, nj, graph)) continue;
+
+            int n_idx = cellToIdx(ni, nj, graph);
+            if (checkCollisionFast(n_idx, graph)) continue;
+
+            // Diagonal moves may not cut the corner of an obstacle.
+            if (n >= 4 && (checkCollisionFast(cellToIdx(ni, c.j, graph), graph) ||
+                           checkCollisionFast(cellToIdx(c.i, nj, graph), graph)))
+            {
+                continue;
+            }
+
+            NodeRecord* neighbor = getNode(nodes, n_idx);
+            if (neighbor == nullptr)
+            {
+                std::cerr << "ERROR: nearestGoalsSearch: Node memory cap of "
+                          << (nodes.memory_cap >> 20) << " MB reached." << std::endl;
+                graph.search_status = SEARCH_MEMORY_CAP;
+                return results;
+            }
+
+            float step = (n < 4) ? 1 : M_SQRT2;
+            if (!neighbor->closed && cost + step < neighbor->cost)
+            {
+                neighbor->cost = cost + step;
+                neighbor->parent = idx;
+                open.push({neighbor->cost, n_idx});
+            }
+        }
+    }
+
+    return results;
+}
+
+
+std::vector<Cell> nearestGoalSearch(GridGraph& graph, const Cell& start,
+                                    const std::vector<Cell>& goals, Cell& reached_goal)
+{
+    std::vector<GoalResult> results = nearestGoalsSearch(graph, start, goals, 1);
+    if (results.empty()) return std::vector<Cell>();
+
+    reached_goal = results[0].goal;
+    return results[0].path;
+}
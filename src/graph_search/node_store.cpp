@@ -0,0 +1,103 @@
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#include <path_planning/utils/math_helpers.h>
+#include <path_planning/utils/graph_utils.h>
+
+#include <path_planning/graph_search/node_store.h>
+
+
+int64_t estimateSearchNodes(const GridGraph& graph, const Cell& start, const Cell& goal)
+{
+    // Assume the search covers a disk a bit larger than the straight line
+    // distance, plus some slack for going around obstacles.
+    double dist = std::hypot(double(goal.i - start.i), double(goal.j - start.j));
+    double radius = 0.75 * dist + 32;
+    int64_t estimate = static_cast<int64_t>(PI * radius * radius);
+    return std::min<int64_t>(estimate, int64_t(graph.width) * graph.height);
+}
+
+
+void initNodeStore(NodeStore& store, int64_t num_keys, int64_t expected_nodes,
+                   NodeStorage storage, size_t memory_cap)
+{
+    store.memory_cap = memory_cap;
+    store.exhausted = false;
+    store.dense.clear();
+    store.keys.clear();
+    store.slots.clear();
+    store.blocks.clear();
+    store.num_nodes = 0;
+    store.hash_bits = 0;
+
+    size_t dense_bytes = num_keys * sizeof(NodeRecord);
+    if (storage == NODES_AUTO)
+    {
+        // A sparse node costs about three times as much as a dense one, so
+        // only use it when the search is expected to touch few of the keys.
+        bool fits = dense_bytes <= memory_cap;
+        storage = (fits && 8 * expected_nodes >= num_keys) ? NODES_DENSE : NODES_SPARSE;
+    }
+
+    if (storage == NODES_DENSE && dense_bytes > memory_cap)
+    {
+        std::cerr << "WARNING: initNodeStore: Dense nodes use " << (dense_bytes >> 20)
+                  << " MB, which is over the memory cap. Using sparse nodes." << std::endl;
+        storage = NODES_SPARSE;
+    }
+
+    if (storage == NODES_DENSE)
+    {
+        store.storage = NODES_DENSE;
+        store.dense.assign(num_keys, {HIGH, -1, 0, false});
+        return;
+    }
+
+    store.storage = NODES_SPARSE;
+    store.hash_bits = 10;
+    while ((int64_t(1) << store.hash_bits) < 2 * std::min(expected_nodes, num_keys)) store.hash_bits++;
+
+    // Start smaller if the expected table would already be over the cap.
+    while (store.hash_bits > 10 &&
+           (size_t(1) << store.hash_bits) * (sizeof(int64_t) + sizeof(int32_t)) > memory_cap / 2)
+    {
+        store.hash_bits--;
+    }
+
+    store.keys.assign(size_t(1) << store.hash_bits, -1);
+    store.slots.assign(size_t(1) << store.hash_bits, 0);
+}
+
+
+void initNodeStore(NodeStore& store, const GridGraph& graph, int64_t num_keys, int64_t expected_nodes)
+{
+    initNodeStore(store, num_keys, expected_nodes, graph.node_storage, graph.node_memory_cap);
+}
+
+
+bool growNodeStore(NodeStore& store)
+{
+    int bits = store.hash_bits + 1;
+    size_t num_slots = size_t(1) << bits;
+    size_t used = num_slots * (sizeof(int64_t) + sizeof(int32_t)) +
+                  store.blocks.size() * (sizeof(NodeRecord) << NODE_BLOCK_BITS);
+    if (used > store.memory_cap) return false;
+
+    std::vector<int64_t> keys(num_slots, -1);
+    std::vector<int32_t> slots(num_slots, 0);
+    for (size_t old_slot = 0; old_slot < store.keys.size(); ++old_slot)
+    {
+        if (store.keys[old_slot] < 0) continue;
+
+        size_t slot = hashNodeKey(store.keys[old_slot], bits);
+        while (keys[slot] >= 0) slot = (slot + 1) & (num_slots - 1);
+        keys[slot] = store.keys[old_slot];
+        slots[slot] = store.slots[old_slot];
+    }
+
+    store.keys.swap(keys);
+    store.slots.swap(slots);
+    store.hash_bits = bits;
+    return true;
+}
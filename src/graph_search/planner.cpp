@@ -0,0 +1,247 @@
+#include <cstring>
+#include <sstream>
+#include <iostream>
+
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/utils/query_trace.h>
+
+#include <path_planning/graph_search/graph_search.h>
+#include <path_planning/graph_search/scratch_search.h>
+#include <path_planning/graph_search/distance_transform.h>
+#include <path_planning/graph_search/coarse_to_fine.h>
+#include <path_planning/graph_search/lattice_planner.h>
+#include <path_planning/graph_search/roadmap.h>
+#include <path_planning/graph_search/planner.h>
+#include <path_planning/graph_search/portfolio.h>
+
+
+bool isValidPlanner(const std::string& algo)
+{
+    return algo == "dfs" || algo == "bfs" || algo == "astar" || algo == "c2f" || algo == "lattice" ||
+           algo == "castar" || algo == "roadmap" || algo == "portfolio";
+}
+
+
+bool isSharedGraphPlanner(const std::string& algo)
+{
+    return isPortfolioPlanner(algo) || algo == "lattice" || algo == "castar" || algo == "roadmap";
+}
+
+
+bool isPortfolioPlanner(const std::string& algo)
+{
+    return algo == "bfs" || algo == "astar";
+}
+
+
+bool computeDistanceTransform(const std::string& dt_mode, GridGraph& graph)
+{
+    if (dt_mode == "none")
+    {
+        // Nothing to compute. Only checkCollision() can be used.
+    }
+    else if (dt_mode == "int")
+    {
+        distanceTransformSquared(graph);
+    }
+    else if (dt_mode == "float")
+    {
+        distanceTransformEuclidean2D(graph);
+    }
+    else
+    {
+        std::cerr << "ERROR: computeDistanceTransform: Invalid distance transform " << dt_mode << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+void recordPlannerOptions(const PlannerOptions& options, QueryRecord& record)
+{
+    record.has_options = 1;
+    record.footprint_length = options.footprint_length;
+    record.footprint_width = options.footprint_width;
+    record.clearance_decay = options.clearance.decay;
+    record.clearance_radius = options.clearance.influence_radius;
+    record.clearance_decay_length = options.clearance.decay_length;
+    record.clearance_weight = options.clearance.weight;
+
+    std::string portfolio;
+    for (auto& name : options.portfolio) portfolio += (portfolio.size() > 0 ? "," : "") + name;
+    if (portfolio.size() >= sizeof(record.portfolio))
+    {
+        std::cerr << "WARNING: recordPlannerOptions: Portfolio list is too long to record." << std::endl;
+        record.has_options = 0;
+    }
+    std::memset(record.portfolio, 0, sizeof(record.portfolio));
+    std::strncpy(record.portfolio, portfolio.c_str(), sizeof(record.portfolio) - 1);
+}
+
+
+bool restorePlannerOptions(const QueryRecord& record, const std::string& algo, PlannerOptions& options)
+{
+    if (!record.has_options)
+    {
+        // Only these planners have options which change their result.
+        return algo != "lattice" && algo != "castar" && algo != "portfolio";
+    }
+
+    options.footprint_length = record.footprint_length;
+    options.footprint_width = record.footprint_width;
+    options.clearance.decay = static_cast<ClearanceDecay>(record.clearance_decay);
+    options.clearance.influence_radius = record.clearance_radius;
+    options.clearance.decay_length = record.clearance_decay_length;
+    options.clearance.weight = record.clearance_weight;
+
+    std::stringstream names(record.portfolio);
+    std::string name;
+    options.portfolio.clear();
+    while (std::getline(names, name, ',')) options.portfolio.push_back(name);
+    return true;
+}
+
+
+void buildPlannerCaches(const std::string& algo, GridGraph& graph, const PlannerOptions& options)
+{
+    if (algo == "castar")
+    {
+        getClearanceLayer(graph, options.clearance);
+    }
+    else if (algo == "roadmap")
+    {
+        getRoadmap(graph, options.roadmap_file);
+    }
+    else if (algo == "c2f")
+    {
+        getMapPyramid(graph);
+    }
+    else if (algo == "portfolio")
+    {
+        for (auto& name : options.portfolio)
+        {
+            if (name != "portfolio") buildPlannerCaches(name, graph, options);
+        }
+    }
+}
+
+
+std::vector<Cell> planPath(const std::string& algo, GridGraph& graph, const Cell& start,
+                           const Cell& goal, const PlannerOptions& options, PlanSummary* summary)
+{
+    std::vector<Cell> path;
+    if (algo == "astar")
+    {
+        path = aStarSearch(graph, start, goal);
+    }
+    else if (algo == "c2f")
+    {
+        // A-star restricted to a corridor around a path on a coarser map.
+        path = coarseToFineSearch(graph, getMapPyramid(graph), start, goal);
+    }
+    else if (algo == "portfolio")
+    {
+        // Run several planners at once. Past wins on this map decide which
+        // planners start first when there are more planners than threads.
+        std::vector<std::string> algos;
+        for (auto& name : options.portfolio)
+        {
+            if (isValidPlanner(name)) algos.push_back(name);
+        }
+
+        uint64_t map_hash = hashMap(graph);
+        PortfolioStats stats;
+        if (options.portfolio_stats.size() > 0 && loadPortfolioStats(options.portfolio_stats, stats))
+        {
+            algos = orderPortfolio(algos, stats, map_hash);
+        }
+
+        PortfolioResult result = runPortfolio(algos, graph, start, goal, options);
+        if (result.winner.size() > 0 && options.portfolio_stats.size() > 0)
+        {
+            stats.wins[map_hash][result.winner]++;
+            savePortfolioStats(options.portfolio_stats, stats);
+        }
+        if (summary != nullptr)
+        {
+            summary->winner = result.winner;
+            summary->winner_us = result.elapsed_us;
+        }
+        path = result.path;
+    }
+    else if (algo == "bfs")
+    {
+        path = breadthFirstSearch(graph, start, goal);
+    }
+    else if (algo == "dfs")
+    {
+        path = depthFirstSearch(graph, start, goal);
+    }
+    else if (isSharedGraphPlanner(algo))
+    {
+        // Keep the planner's caches with the graph, then search with the
+        // graph's own scratch.
+        buildPlannerCaches(algo, graph, options);
+        path = planPath(algo, graph, graph, start, goal, options, summary);
+    }
+    else
+    {
+        std::cerr << "ERROR: planPath: Invalid planning algorithm " << algo << std::endl;
+    }
+
+    return path;
+}
+
+
+std::vector<Cell> planPath(const std::string& algo, const GridGraph& graph, SearchScratch& scratch,
+                           const Cell& start, const Cell& goal, const PlannerOptions& options, PlanSummary* summary)
+{
+    std::vector<Cell> path;
+    if (algo == "bfs")
+    {
+        path = scratchBreadthFirstSearch(graph, scratch, start, goal);
+    }
+    else if (algo == "astar")
+    {
+        path = scratchAStarSearch(graph, scratch, start, goal);
+    }
+    else if (algo == "lattice")
+    {
+        // Search over (i, j, heading) with the robot footprint, starting facing along x.
+        Lattice lattice;
+        initLattice(graph, makeRectangleFootprint(options.footprint_length, options.footprint_width), lattice);
+        path = latticePathToCells(latticeSearch(graph, scratch, lattice, {start.i, start.j, 0}, goal));
+    }
+    else if (algo == "castar")
+    {
+        // A-star with extra cost for passing close to obstacles.
+        ClearanceLayer layer;
+        const ClearanceLayer* current = graph.clearance.get();
+        if (current == nullptr || !isClearanceLayerCurrent(graph, *current, options.clearance))
+        {
+            updateClearanceLayer(graph, layer, options.clearance);
+            current = &layer;
+        }
+        ClearanceResult result = clearanceAStarSearch(graph, scratch, *current, start, goal);
+        if (summary != nullptr) summary->clearance_cost = result.clearance_cost;
+        path = result.path;
+    }
+    else if (algo == "roadmap")
+    {
+        // Search the Voronoi roadmap, built once per map and collision radius.
+        Roadmap roadmap;
+        const Roadmap* current = graph.roadmap.get();
+        if (current == nullptr || !isRoadmapCurrent(graph, *current))
+        {
+            loadOrBuildRoadmap(graph, options.roadmap_file, roadmap);
+            current = &roadmap;
+        }
+        path = roadmapSearch(graph, scratch, *current, start, goal);
+    }
+    else
+    {
+        std::cerr << "ERROR: planPath: " << algo << " can't plan on a shared graph." << std::endl;
+    }
+
+    return path;
+}
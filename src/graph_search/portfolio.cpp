@@ -0,0 +1,180 @@
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/utils/query_trace.h>
+
+#include <path_planning/graph_search/planner.h>
+#include <path_planning/graph_search/portfolio.h>
+
+
+bool loadPortfolioStats(const std::string& file_path, PortfolioStats& stats)
+{
+    stats.wins.clear();
+
+    std::ifstream in(file_path);
+    if (!in.is_open()) return true;  // No stats yet.
+
+    uint64_t map_hash;
+    std::string algo;
+    int wins;
+    while (in >> std::hex >> map_hash >> std::dec >> algo >> wins)
+    {
+        stats.wins[map_hash][algo] += wins;
+    }
+
+    if (!in.eof())
+    {
+        std::cerr << "ERROR: loadPortfolioStats: Could not read " << file_path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+bool savePortfolioStats(const std::string& file_path, const PortfolioStats& stats)
+{
+    std::ofstream out(file_path);
+    if (!out.is_open())
+    {
+        std::cerr << "ERROR: savePortfolioStats: Could not open " << file_path << std::endl;
+        return false;
+    }
+
+    for (auto& map_wins : stats.wins)
+    {
+        for (auto& algo_wins : map_wins.second)
+        {
+            out << std::hex << map_wins.first << std::dec << " " << algo_wins.first << " " << algo_wins.second << "\n";
+        }
+    }
+    return true;
+}
+
+
+std::vector<std::string> orderPortfolio(const std::vector<std::string>& algos, const PortfolioStats& stats,
+                                        uint64_t map_hash)
+{
+    std::map<std::string, int> map_wins, total_wins;
+    for (auto& entry : stats.wins)
+    {
+        for (auto& algo_wins : entry.second)
+        {
+            total_wins[algo_wins.first] += algo_wins.second;
+            if (entry.first == map_hash) map_wins[algo_wins.first] += algo_wins.second;
+        }
+    }
+
+    std::vector<std::string> order = algos;
+    std::stable_sort(order.begin(), order.end(), [&](const std::string& a, const std::string& b)
+    {
+        if (map_wins[a] != map_wins[b]) return map_wins[a] > map_wins[b];
+        return total_wins[a] > total_wins[b];
+    });
+    return order;
+}
+
+
+bool isValidPath(const std::vector<Cell>& path, const Cell& start, const Cell& goal, const GridGraph& graph)
+{
+    if (path.size() == 0) return false;
+    if (path.front().i != start.i || path.front().j != start.j) return false;
+    if (path.back().i != goal.i || path.back().j != goal.j) return false;
+
+    bool use_dt = !graph.obstacle_sq_distances.empty();
+    for (size_t k = 0; k < path.size(); ++k)
+    {
+        if (!isCellInBounds(path[k].i, path[k].j, graph)) return false;
+        if (k > 0 && (std::abs(path[k].i - path[k - 1].i) > 1 || std::abs(path[k].j - path[k - 1].j) > 1))
+        {
+            return false;
+        }
+
+        // The start cell may be in collision if the robot is close to a wall.
+        int idx = cellToIdx(path[k].i, path[k].j, graph);
+        if (k > 0 && (use_dt ? checkCollisionFast(idx, graph) : checkCollision(idx, graph))) return false;
+    }
+    return true;
+}
+
+
+PortfolioResult runPortfolio(const std::vector<std::string>& algos, GridGraph& graph, const Cell& start,
+                             const Cell& goal, const PlannerOptions& options, int max_threads)
+{
+    PortfolioResult result = {std::vector<Cell>(), "", 0};
+
+    std::vector<std::string> shared_algos;
+    for (auto& algo : algos)
+    {
+        if (isPortfolioPlanner(algo))
+        {
+            shared_algos.push_back(algo);
+        }
+        else
+        {
+            std::cerr << "WARNING: runPortfolio: Leaving out " << algo
+                      << ", since only bfs and astar can run in a portfolio." << std::endl;
+        }
+    }
+    if (shared_algos.empty()) return result;
+
+    // Build the caches the planners read before the threads start, since the
+    // workers only read the graph.
+    for (auto& algo : shared_algos) buildPlannerCaches(algo, graph, options);
+
+    if (max_threads <= 0) max_threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+    max_threads = std::min<int>(max_threads, shared_algos.size());
+
+    std::atomic<bool> cancel(false);
+    std::atomic<size_t> next_algo(0);
+    std::mutex result_mutex;
+    SearchScratch winner;
+    uint64_t start_time = traceTimeMicro();
+
+    // Each thread takes the next planner in order until one of them wins. The
+    // graph is shared, and each planner keeps its search state in a scratch.
+    const GridGraph& shared = graph;
+    auto worker = [&]()
+    {
+        while (!cancel.load())
+        {
+            size_t k = next_algo++;
+            if (k >= shared_algos.size()) return;
+
+            SearchScratch scratch;
+            scratch.visited_policy = shared.visited_policy;
+            scratch.visited_param = shared.visited_param;
+            scratch.cancel = &cancel;
+            std::vector<Cell> path = planPath(shared_algos[k], shared, scratch, start, goal, options);
+
+            if (cancel.load() || !isValidPath(path, start, goal, shared)) continue;
+
+            std::lock_guard<std::mutex> lock(result_mutex);
+            if (result.winner.size() > 0) return;
+            cancel = true;
+            result.path = path;
+            result.winner = shared_algos[k];
+            result.elapsed_us = traceTimeMicro() - start_time;
+            winner = scratch;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < max_threads; ++t) threads.emplace_back(worker);
+    for (auto& thread : threads) thread.join();
+
+    // Show the visited cells of the winner.
+    if (result.winner.size() > 0)
+    {
+        graph.visited_count = winner.visited_count;
+        graph.visited_cells.swap(winner.visited_cells);
+        graph.visited_bits.swap(winner.visited_bits);
+        graph.search_status = winner.search_status;
+    }
+
+    return result;
+}
@@ -0,0 +1,789 @@
+#include <cmath>
+#include <queue>
+#include <memory>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <path_planning/utils/math_helpers.h>
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/utils/query_trace.h>
+
+#include <path_planning/graph_search/node_store.h>
+#include <path_planning/graph_search/roadmap.h>
+
+
+static const char ROADMAP_MAGIC[8] = {'P', 'P', 'R', 'O', 'A', 'D', 'M', '2'};
+
+// The 8 neighbors of a cell in order around it, starting east. Even entries
+// are the 4-connected neighbors.
+static const int RING_DI[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+static const int RING_DJ[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+
+/**
+ * Distance from the cell to the nearest obstacle, in cells.
+ */
+static float obstacleDistance(int idx, const GridGraph& graph)
+{
+    if (!graph.obstacle_sq_distances.empty()) return std::sqrt(float(graph.obstacle_sq_distances[idx]));
+    return graph.obstacle_distances[idx];
+}
+
+
+/**
+ * Bit k of the result is set if the k-th neighbor of the cell is in the set.
+ * Cells outside the map are never in the set.
+ */
+static int ringMask(int i, int j, const std::vector<uint8_t>& in_set, const GridGraph& graph)
+{
+    int mask = 0;
+    for (int k = 0; k < 8; ++k)
+    {
+        int ni = i + RING_DI[k], nj = j + RING_DJ[k];
+        if (isCellInBounds(ni, nj, graph) && in_set[cellToIdx(ni, nj, graph)]) mask |= 1 << k;
+    }
+    return mask;
+}
+
+
+/**
+ * Counts the connected groups of ring positions whose bit in the mask equals
+ * value. With four_connected, positions must share a side to be connected and
+ * only groups which contain a 4-connected neighbor of the center are counted.
+ */
+static int countRingGroups(int mask, int value, bool four_connected)
+{
+    int seen = 0, groups = 0;
+    for (int k = 0; k < 8; ++k)
+    {
+        if (((mask >> k) & 1) != value || (seen >> k) & 1) continue;
+
+        bool touches_center = k % 2 == 0;
+        int stack[8], top = 0;
+        stack[top++] = k;
+        seen |= 1 << k;
+        while (top > 0)
+        {
+            int a = stack[--top];
+            for (int b = 0; b < 8; ++b)
+            {
+                if (((mask >> b) & 1) != value || (seen >> b) & 1) continue;
+                int di = std::abs(RING_DI[a] - RING_DI[b]), dj = std::abs(RING_DJ[a] - RING_DJ[b]);
+                bool adjacent = four_connected ? di + dj == 1 : std::max(di, dj) == 1;
+                if (!adjacent) continue;
+                seen |= 1 << b;
+                touches_center |= b % 2 == 0;
+                stack[top++] = b;
+            }
+        }
+        if (!four_connected || touches_center) groups++;
+    }
+    return groups;
+}
+
+
+/**
+ * A cell is simple if removing it from the free space does not change the
+ * connectivity of the free space (8-connected) or the obstacles (4-connected).
+ * Returns a table of which neighbor masks make a cell simple.
+ */
+static std::vector<bool> makeSimpleTable()
+{
+    std::vector<bool> simple(256);
+    for (int mask = 0; mask < 256; ++mask)
+    {
+        simple[mask] = countRingGroups(mask, 1, false) == 1 && countRingGroups(mask, 0, true) == 1;
+    }
+    return simple;
+}
+
+
+/**
+ * Checks whether the cell is on a ridge of the distance transform, meaning it
+ * is at least as far from obstacles as both of its neighbors along some line
+ * through it, and further than one of them.
+ */
+static bool isRidge(int i, int j, const GridGraph& graph)
+{
+    float dist = obstacleDistance(cellToIdx(i, j, graph), graph);
+    for (int k = 0; k < 4; ++k)
+    {
+        int ai = i + RING_DI[k], aj = j + RING_DJ[k];
+        int bi = i - RING_DI[k], bj = j - RING_DJ[k];
+        if (!isCellInBounds(ai, aj, graph) || !isCellInBounds(bi, bj, graph)) continue;
+
+        float dist_a = obstacleDistance(cellToIdx(ai, aj, graph), graph);
+        float dist_b = obstacleDistance(cellToIdx(bi, bj, graph), graph);
+        if (dist >= dist_a && dist >= dist_b && (dist > dist_a || dist > dist_b)) return true;
+    }
+    return false;
+}
+
+
+static inline int popCount(int mask)
+{
+    int count = 0;
+    for (; mask; mask &= mask - 1) count++;
+    return count;
+}
+
+
+/**
+ * Thins the free cells to a skeleton one cell wide, removing cells closest to
+ * obstacles first. Dead ends are kept where they are on a ridge so the
+ * skeleton reaches into corridors and rooms. Only cells on the border of the
+ * remaining free space can be removed, so only those are queued, and removing
+ * a cell queues its neighbors to be checked again.
+ */
+static void thinFreeSpace(const GridGraph& graph, std::vector<uint8_t>& skeleton)
+{
+    static const std::vector<bool> simple = makeSimpleTable();
+
+    int num_cells = graph.width * graph.height;
+    skeleton.assign(num_cells, 0);
+    for (int idx = 0; idx < num_cells; ++idx)
+    {
+        if (!checkCollisionFast(idx, graph)) skeleton[idx] = 1;
+    }
+
+    // Cells are queued in buckets by squared obstacle distance, saturated like
+    // the integer distance transform. A cell queued below the bucket being
+    // thinned goes in that bucket, so it is checked again.
+    std::vector<std::vector<int> > buckets;
+    std::vector<uint8_t> queued(num_cells, 0);
+    size_t current = 0;
+    auto enqueue = [&](int idx)
+    {
+        if (queued[idx]) return;
+        queued[idx] = 1;
+        float dist = obstacleDistance(idx, graph);
+        size_t key = std::max(static_cast<size_t>(std::min(dist * dist, float(UINT16_MAX))), current);
+        if (key >= buckets.size()) buckets.resize(key + 1);
+        buckets[key].push_back(idx);
+    };
+    for (int idx = 0; idx < num_cells; ++idx)
+    {
+        if (!skeleton[idx]) continue;
+        Cell c = idxToCell(idx, graph);
+        if (ringMask(c.i, c.j, skeleton, graph) != 0xff) enqueue(idx);
+    }
+
+    for (; current < buckets.size(); ++current)
+    {
+        // The bucket can grow while it is thinned.
+        for (size_t k = 0; k < buckets[current].size(); ++k)
+        {
+            int idx = buckets[current][k];
+            queued[idx] = 0;
+
+            Cell c = idxToCell(idx, graph);
+            int mask = ringMask(c.i, c.j, skeleton, graph);
+            bool dead_end = popCount(mask) == 1;
+            if (!simple[mask] || (dead_end && isRidge(c.i, c.j, graph))) continue;
+
+            skeleton[idx] = 0;
+            for (int n = 0; n < 8; ++n)
+            {
+                if ((mask >> n) & 1) enqueue(cellToIdx(c.i + RING_DI[n], c.j + RING_DJ[n], graph));
+            }
+        }
+        std::vector<int>().swap(buckets[current]);
+    }
+}
+
+
+/**
+ * Removes dead end branches shorter than min_spur cells which end at a
+ * junction. These come from small bumps in the obstacles.
+ */
+static void pruneSpurs(const GridGraph& graph, std::vector<uint8_t>& skeleton, int min_spur)
+{
+    int num_cells = graph.width * graph.height;
+    std::vector<int> branch;
+    for (int idx = 0; idx < num_cells; ++idx)
+    {
+        if (!skeleton[idx]) continue;
+        Cell c = idxToCell(idx, graph);
+        if (popCount(ringMask(c.i, c.j, skeleton, graph)) != 1) continue;
+
+        // Walk from the dead end until reaching a junction or another dead end.
+        branch.clear();
+        int prev = -1, cur = idx;
+        bool at_junction = false;
+        while (branch.size() < size_t(min_spur))
+        {
+            Cell cc = idxToCell(cur, graph);
+            int mask = ringMask(cc.i, cc.j, skeleton, graph);
+            if (popCount(mask) > 2)
+            {
+                at_junction = true;
+                break;
+            }
+            branch.push_back(cur);
+
+            int next = -1;
+            for (int k = 0; k < 8; ++k)
+            {
+                if (!((mask >> k) & 1)) continue;
+                int n_idx = cellToIdx(cc.i + RING_DI[k], cc.j + RING_DJ[k], graph);
+                if (n_idx != prev) next = n_idx;
+            }
+            if (next < 0) break;
+            prev = cur;
+            cur = next;
+        }
+
+        if (at_junction)
+        {
+            for (int b : branch) skeleton[b] = 0;
+        }
+    }
+}
+
+
+bool buildRoadmap(const GridGraph& graph, Roadmap& roadmap, int node_spacing, int min_spur)
+{
+    int num_cells = graph.width * graph.height;
+    if (graph.obstacle_sq_distances.empty() && graph.obstacle_distances.size() != size_t(num_cells))
+    {
+        std::cerr << "ERROR: buildRoadmap: No distance transform has been computed." << std::endl;
+        return false;
+    }
+    node_spacing = std::max(node_spacing, 2);
+
+    std::vector<uint8_t> skeleton;
+    thinFreeSpace(graph, skeleton);
+    pruneSpurs(graph, skeleton, min_spur);
+
+    roadmap = Roadmap();
+    roadmap.map_hash = hashMap(graph);
+    roadmap.dt_hash = hashDistanceTransform(graph);
+    roadmap.collision_radius = graph.collision_radius;
+    roadmap.collision_sq_threshold = graph.collision_sq_threshold;
+    roadmap.width = graph.width;
+    roadmap.height = graph.height;
+    roadmap.dt_version = graph.dt_version;
+
+    // Every skeleton cell that is not in the middle of a chain is a node.
+    std::vector<int> node_of(num_cells, -1);
+    auto addNode = [&](int idx)
+    {
+        node_of[idx] = roadmap.node_cells.size();
+        roadmap.node_cells.push_back(idx);
+    };
+    for (int idx = 0; idx < num_cells; ++idx)
+    {
+        if (!skeleton[idx]) continue;
+        Cell c = idxToCell(idx, graph);
+        if (popCount(ringMask(c.i, c.j, skeleton, graph)) != 2) addNode(idx);
+    }
+    int num_junctions = roadmap.node_cells.size();
+
+    struct Edge
+    {
+        int a, b;
+        float weight;
+        std::vector<int> chain;
+    };
+    std::vector<Edge> edges;
+    auto addEdge = [&](int a, int b, float weight, std::vector<int>& chain)
+    {
+        if (a == b) return;
+        if (a > b)
+        {
+            std::swap(a, b);
+            std::reverse(chain.begin(), chain.end());
+        }
+        edges.push_back({a, b, weight, chain});
+    };
+    auto stepLength = [&](int from, int to)
+    {
+        Cell a = idxToCell(from, graph), b = idxToCell(to, graph);
+        return (a.i != b.i && a.j != b.j) ? float(M_SQRT2) : 1.0f;
+    };
+
+    // Follows the chain of cells from node into first, adding a node every
+    // node_spacing cells, until another node is reached.
+    std::vector<uint8_t> in_chain(num_cells, 0);
+    std::vector<int> chain;
+    auto traceChain = [&](int node, int first)
+    {
+        int prev = roadmap.node_cells[node], cur = first;
+        float weight = stepLength(prev, cur);
+        chain.clear();
+        while (true)
+        {
+            if (node_of[cur] >= 0)
+            {
+                addEdge(node, node_of[cur], weight, chain);
+                return;
+            }
+            if (in_chain[cur]) return;  // Already traced from the other end.
+            in_chain[cur] = 1;
+
+            if (int(chain.size()) + 1 >= node_spacing)
+            {
+                addNode(cur);
+                addEdge(node, node_of[cur], weight, chain);
+                node = node_of[cur];
+                weight = 0;
+                chain.clear();
+            }
+            else
+            {
+                chain.push_back(cur);
+            }
+
+            Cell c = idxToCell(cur, graph);
+            int mask = ringMask(c.i, c.j, skeleton, graph);
+            int next = -1;
+            for (int k = 0; k < 8; ++k)
+            {
+                if (!((mask >> k) & 1)) continue;
+                int n_idx = cellToIdx(c.i + RING_DI[k], c.j + RING_DJ[k], graph);
+                if (n_idx != prev) next = n_idx;
+            }
+            weight += stepLength(cur, next);
+            prev = cur;
+            cur = next;
+        }
+    };
+
+    for (int n = 0; n < num_junctions; ++n)
+    {
+        Cell c = idxToCell(roadmap.node_cells[n], graph);
+        int mask = ringMask(c.i, c.j, skeleton, graph);
+        for (int k = 0; k < 8; ++k)
+        {
+            if (!((mask >> k) & 1)) continue;
+            int n_idx = cellToIdx(c.i + RING_DI[k], c.j + RING_DJ[k], graph);
+            if (node_of[n_idx] >= 0)
+            {
+                // Neighboring junction cells. Add the edge once.
+                std::vector<int> no_cells;
+                if (n < node_of[n_idx]) addEdge(n, node_of[n_idx], stepLength(roadmap.node_cells[n], n_idx), no_cells);
+            }
+            else if (!in_chain[n_idx])
+            {
+                traceChain(n, n_idx);
+            }
+        }
+    }
+
+    // Loops around obstacles have no junctions. Start a node on each.
+    for (int idx = 0; idx < num_cells; ++idx)
+    {
+        if (!skeleton[idx] || node_of[idx] >= 0 || in_chain[idx]) continue;
+        addNode(idx);
+        int n = node_of[idx];
+        Cell c = idxToCell(idx, graph);
+        int mask = ringMask(c.i, c.j, skeleton, graph);
+        for (int k = 0; k < 8; ++k)
+        {
+            if (!((mask >> k) & 1)) continue;
+            int n_idx = cellToIdx(c.i + RING_DI[k], c.j + RING_DJ[k], graph);
+            if (!in_chain[n_idx] && node_of[n_idx] < 0) traceChain(n, n_idx);
+        }
+    }
+
+    // Pack the edges in compressed sparse row form, once in each direction.
+    int num_nodes = roadmap.node_cells.size();
+    roadmap.offsets.assign(num_nodes + 1, 0);
+    for (auto& e : edges)
+    {
+        roadmap.offsets[e.a + 1]++;
+        roadmap.offsets[e.b + 1]++;
+    }
+    for (int n = 0; n < num_nodes; ++n) roadmap.offsets[n + 1] += roadmap.offsets[n];
+
+    roadmap.targets.resize(2 * edges.size());
+    roadmap.weights.resize(2 * edges.size());
+    roadmap.edge_ids.resize(2 * edges.size());
+    roadmap.chain_offsets.assign(1, 0);
+    std::vector<int> fill(roadmap.offsets.begin(), roadmap.offsets.end() - 1);
+    for (int e = 0; e < int(edges.size()); ++e)
+    {
+        int ea = fill[edges[e].a]++, eb = fill[edges[e].b]++;
+        roadmap.targets[ea] = edges[e].b;
+        roadmap.targets[eb] = edges[e].a;
+        roadmap.weights[ea] = roadmap.weights[eb] = edges[e].weight;
+        roadmap.edge_ids[ea] = roadmap.edge_ids[eb] = e;
+
+        roadmap.chain_cells.insert(roadmap.chain_cells.end(), edges[e].chain.begin(), edges[e].chain.end());
+        roadmap.chain_offsets.push_back(roadmap.chain_cells.size());
+    }
+
+    for (int n = 0; n < num_nodes; ++n) roadmap.node_at[roadmap.node_cells[n]] = n;
+
+    return true;
+}
+
+
+/**
+ * Writes or reads a plain value or an array in the machine's byte order.
+ * Arrays are stored as their length followed by the values.
+ */
+template <class T>
+static inline void writeField(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+static inline void readField(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+template <class T>
+static inline void writeArray(std::ostream& out, const std::vector<T>& values)
+{
+    int64_t size = values.size();
+    writeField(out, size);
+    out.write(reinterpret_cast<const char*>(values.data()), size * sizeof(T));
+}
+
+template <class T>
+static inline bool readArray(std::istream& in, std::vector<T>& values)
+{
+    int64_t size = -1;
+    readField(in, size);
+    if (!in || size < 0) return false;
+    values.resize(size);
+    in.read(reinterpret_cast<char*>(values.data()), size * sizeof(T));
+    return bool(in);
+}
+
+
+std::string roadmapFilePath(const std::string& map_file)
+{
+    std::string base = map_file;
+    if (base.size() > 4 && base.compare(base.size() - 4, 4, ".map") == 0) base.resize(base.size() - 4);
+    return base + ".roadmap";
+}
+
+
+bool saveRoadmap(const std::string& file_path, const Roadmap& roadmap)
+{
+    if (roadmap.node_cells.empty())
+    {
+        std::cerr << "ERROR: saveRoadmap: Not saving an empty roadmap to " << file_path << std::endl;
+        return false;
+    }
+
+    std::ofstream out(file_path, std::ios::binary);
+    if (!out.is_open())
+    {
+        std::cerr << "ERROR: saveRoadmap: Failed to open " << file_path << std::endl;
+        return false;
+    }
+
+    out.write(ROADMAP_MAGIC, sizeof(ROADMAP_MAGIC));
+    writeField(out, roadmap.map_hash);
+    writeField(out, roadmap.dt_hash);
+    writeField(out, roadmap.collision_radius);
+    writeField(out, roadmap.collision_sq_threshold);
+    writeField(out, roadmap.width);
+    writeField(out, roadmap.height);
+    writeArray(out, roadmap.node_cells);
+    writeArray(out, roadmap.offsets);
+    writeArray(out, roadmap.targets);
+    writeArray(out, roadmap.weights);
+    writeArray(out, roadmap.edge_ids);
+    writeArray(out, roadmap.chain_offsets);
+    writeArray(out, roadmap.chain_cells);
+
+    return out.good();
+}
+
+
+bool loadRoadmap(const std::string& file_path, const GridGraph& graph, Roadmap& roadmap)
+{
+    std::ifstream in(file_path, std::ios::binary);
+    if (!in.is_open()) return false;  // No saved roadmap.
+
+    char magic[sizeof(ROADMAP_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, ROADMAP_MAGIC, sizeof(magic)) != 0)
+    {
+        std::cerr << "ERROR: loadRoadmap: Not a roadmap file: " << file_path << std::endl;
+        return false;
+    }
+
+    roadmap = Roadmap();
+    readField(in, roadmap.map_hash);
+    readField(in, roadmap.dt_hash);
+    readField(in, roadmap.collision_radius);
+    readField(in, roadmap.collision_sq_threshold);
+    readField(in, roadmap.width);
+    readField(in, roadmap.height);
+    if (!in) return false;
+
+    // A roadmap for another map, distance transform or robot size has to be
+    // rebuilt.
+    if (roadmap.map_hash != hashMap(graph) || roadmap.dt_hash != hashDistanceTransform(graph) ||
+        roadmap.collision_radius != graph.collision_radius ||
+        roadmap.collision_sq_threshold != graph.collision_sq_threshold)
+    {
+        return false;
+    }
+    roadmap.dt_version = graph.dt_version;
+
+    bool ok = readArray(in, roadmap.node_cells) && readArray(in, roadmap.offsets) &&
+              readArray(in, roadmap.targets) && readArray(in, roadmap.weights) &&
+              readArray(in, roadmap.edge_ids) && readArray(in, roadmap.chain_offsets) &&
+              readArray(in, roadmap.chain_cells);
+    if (!ok || roadmap.offsets.size() != roadmap.node_cells.size() + 1)
+    {
+        std::cerr << "ERROR: loadRoadmap: Failed to read " << file_path << std::endl;
+        return false;
+    }
+
+    for (int n = 0; n < int(roadmap.node_cells.size()); ++n) roadmap.node_at[roadmap.node_cells[n]] = n;
+    return true;
+}
+
+
+bool isRoadmapCurrent(const GridGraph& graph, const Roadmap& roadmap)
+{
+    return roadmap.dt_version == graph.dt_version && roadmap.collision_radius == graph.collision_radius &&
+           roadmap.collision_sq_threshold == graph.collision_sq_threshold &&
+           roadmap.width == graph.width && roadmap.height == graph.height;
+}
+
+
+void loadOrBuildRoadmap(const GridGraph& graph, const std::string& file_path, Roadmap& roadmap)
+{
+    if (file_path.size() > 0 && loadRoadmap(file_path, graph, roadmap)) return;
+
+    if (buildRoadmap(graph, roadmap) && file_path.size() > 0 && roadmap.node_cells.size() > 0)
+    {
+        saveRoadmap(file_path, roadmap);
+    }
+}
+
+
+const Roadmap& getRoadmap(GridGraph& graph, const std::string& file_path)
+{
+    if (!graph.roadmap || !isRoadmapCurrent(graph, *graph.roadmap))
+    {
+        std::shared_ptr<Roadmap> roadmap = std::make_shared<Roadmap>();
+        loadOrBuildRoadmap(graph, file_path, *roadmap);
+        graph.roadmap = roadmap;
+    }
+    return *graph.roadmap;
+}
+
+
+/**
+ * Runs Dijkstra on the grid from the cell until it has reached num_nodes
+ * roadmap nodes or the target cell. The costs to the reached nodes are added
+ * to reached, as (node, cost) pairs.
+ * @return  True if the target cell was reached.
+ */
+static bool localSearch(const GridGraph& graph, SearchScratch& scratch, const Roadmap& roadmap, const Cell& from,
+                        int target_idx, size_t num_nodes, NodeStore& nodes, std::vector<std::pair<int, float> >& reached)
+{
+    initNodeStore(nodes, graph, int64_t(graph.width) * graph.height,
+                  int64_t(16) * ROADMAP_NODE_SPACING * ROADMAP_NODE_SPACING);
+
+    typedef std::pair<float, int> QueueItem;  // Cost, index.
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > open;
+
+    int from_idx = cellToIdx(from.i, from.j, graph);
+    getNode(nodes, from_idx)->cost = 0;
+    open.push({0, from_idx});
+
+    int expansions = 0;
+    while (!open.empty())
+    {
+        if (++expansions % SEARCH_CANCEL_INTERVAL == 0 && isSearchCancelled(scratch)) return false;
+
+        int idx = open.top().second;
+        open.pop();
+
+        NodeRecord* node = findNode(nodes, idx);
+        if (node->closed) continue;  // Stale queue entry.
+        node->closed = true;
+        float cost = node->cost;
+
+        if (idx == target_idx) return true;
+
+        auto on_roadmap = roadmap.node_at.find(idx);
+        if (on_roadmap != roadmap.node_at.end())
+        {
+            reached.push_back({on_roadmap->second, cost});
+            if (reached.size() >= num_nodes) return false;
+        }
+
+        Cell c = idxToCell(idx, graph);
+        recordVisited(c, graph, scratch);
+
+        for (int k = 0; k < 8; ++k)
+        {
+            int ni = c.i + RING_DI[k], nj = c.j + RING_DJ[k];
+            if (!isCellInBounds(ni, nj, graph)) continue;
+
+            int n_idx = cellToIdx(ni, nj, graph);
+            if (checkCollisionFast(n_idx, graph)) continue;
+
+            NodeRecord* neighbor = getNode(nodes, n_idx);
+            if (neighbor == nullptr)
+            {
+                std::cerr << "ERROR: localSearch: Node memory cap of "
+                          << (nodes.memory_cap >> 20) << " MB reached." << std::endl;
+                scratch.search_status = SEARCH_MEMORY_CAP;
+                return false;
+            }
+
+            float next_cost = cost + ((k % 2 == 0) ? 1 : M_SQRT2);
+            if (!neighbor->closed && next_cost < neighbor->cost)
+            {
+                neighbor->cost = next_cost;
+                neighbor->parent = idx;
+                open.push({next_cost, n_idx});
+            }
+        }
+    }
+    return false;
+}
+
+
+/**
+ * Adds the cells from the search origin to the cell, in that order.
+ */
+static void appendLocalPath(NodeStore& nodes, int idx, const GridGraph& graph, std::vector<Cell>& path)
+{
+    std::vector<Cell> local;
+    for (int cur = idx; cur >= 0; cur = findNode(nodes, cur)->parent) local.push_back(idxToCell(cur, graph));
+    path.insert(path.end(), local.rbegin(), local.rend());
+}
+
+
+std::vector<Cell> roadmapSearch(GridGraph& graph, const Roadmap& roadmap, const Cell& start, const Cell& goal,
+                                int local_nodes)
+{
+    return roadmapSearch(graph, graph, roadmap, start, goal, local_nodes);
+}
+
+
+std::vector<Cell> roadmapSearch(const GridGraph& graph, SearchScratch& scratch, const Roadmap& roadmap,
+                                const Cell& start, const Cell& goal, int local_nodes)
+{
+    std::vector<Cell> path;
+
+    initSearchScratch(graph, scratch);  // Make sure the visited cells are reset.
+
+    if (roadmap.width != graph.width || roadmap.height != graph.height)
+    {
+        std::cerr << "ERROR: roadmapSearch: The roadmap is for a different map." << std::endl;
+        return path;
+    }
+    if (!isCellInBounds(start.i, start.j, graph) || !isCellInBounds(goal.i, goal.j, graph)) return path;
+
+    int goal_idx = cellToIdx(goal.i, goal.j, graph);
+
+    // Connect the start to the roadmap. Nearby goals are reached directly.
+    NodeStore start_nodes, goal_nodes;
+    std::vector<std::pair<int, float> > start_reached, goal_reached;
+    if (localSearch(graph, scratch, roadmap, start, goal_idx, local_nodes, start_nodes, start_reached))
+    {
+        appendLocalPath(start_nodes, goal_idx, graph, path);
+        return path;
+    }
+    localSearch(graph, scratch, roadmap, goal, -1, local_nodes, goal_nodes, goal_reached);
+    if (start_reached.empty() || goal_reached.empty() || isSearchCancelled(scratch)) return path;
+
+    // Dijkstra on the roadmap, from the nodes near the start to the nodes near
+    // the goal.
+    int num_nodes = roadmap.node_cells.size();
+    std::vector<float> cost(num_nodes, HIGH), goal_cost(num_nodes, HIGH);
+    std::vector<int> parent(num_nodes, -1), parent_edge(num_nodes, -1);
+    std::vector<uint8_t> closed(num_nodes, 0);
+    for (auto& r : goal_reached) goal_cost[r.first] = std::min(goal_cost[r.first], r.second);
+
+    typedef std::pair<float, int> QueueItem;  // Cost, node.
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > open;
+    for (auto& r : start_reached)
+    {
+        if (r.second < cost[r.first])
+        {
+            cost[r.first] = r.second;
+            open.push({r.second, r.first});
+        }
+    }
+
+    float best_cost = HIGH;
+    int best_node = -1;
+    int expansions = 0;
+    while (!open.empty())
+    {
+        if (++expansions % SEARCH_CANCEL_INTERVAL == 0 && isSearchCancelled(scratch)) return path;
+
+        float node_cost = open.top().first;
+        int n = open.top().second;
+        open.pop();
+
+        if (node_cost >= best_cost) break;
+        if (closed[n]) continue;  // Stale queue entry.
+        closed[n] = 1;
+        recordVisited(idxToCell(roadmap.node_cells[n], graph), graph, scratch);
+
+        if (node_cost + goal_cost[n] < best_cost)
+        {
+            best_cost = node_cost + goal_cost[n];
+            best_node = n;
+        }
+
+        for (int e = roadmap.offsets[n]; e < roadmap.offsets[n + 1]; ++e)
+        {
+            int m = roadmap.targets[e];
+            float next_cost = node_cost + roadmap.weights[e];
+            if (!closed[m] && next_cost < cost[m])
+            {
+                cost[m] = next_cost;
+                parent[m] = n;
+                parent_edge[m] = e;
+                open.push({next_cost, m});
+            }
+        }
+    }
+    if (best_node < 0) return path;
+
+    // Walk back to find the edges used, then join the three parts.
+    std::vector<int> route;
+    int entry = best_node;
+    for (; parent[entry] >= 0; entry = parent[entry]) route.push_back(parent_edge[entry]);
+    std::reverse(route.begin(), route.end());
+
+    appendLocalPath(start_nodes, roadmap.node_cells[entry], graph, path);
+    int from = entry;
+    for (int e : route)
+    {
+        int to = roadmap.targets[e];
+        int id = roadmap.edge_ids[e];
+        int first = roadmap.chain_offsets[id], last = roadmap.chain_offsets[id + 1];
+        if (from < to)
+        {
+            for (int k = first; k < last; ++k) path.push_back(idxToCell(roadmap.chain_cells[k], graph));
+        }
+        else
+        {
+            for (int k = last - 1; k >= first; --k) path.push_back(idxToCell(roadmap.chain_cells[k], graph));
+        }
+        path.push_back(idxToCell(roadmap.node_cells[to], graph));
+        from = to;
+    }
+
+    // The goal search ran from the goal, so its parents lead to the goal.
+    for (int cur = findNode(goal_nodes, roadmap.node_cells[best_node])->parent; cur >= 0;
+         cur = findNode(goal_nodes, cur)->parent)
+    {
+        path.push_back(idxToCell(cur, graph));
+    }
+
+    return path;
+}
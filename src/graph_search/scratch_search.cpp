@@ -0,0 +1,188 @@
+#include <cmath>
+#include <queue>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include <path_planning/utils/graph_utils.h>
+
+#include <path_planning/graph_search/node_store.h>
+#include <path_planning/graph_search/scratch_search.h>
+
+
+static const int STEP_DI[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+static const int STEP_DJ[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+
+/**
+ * Follows the parents in the store from the goal back to the start.
+ */
+static std::vector<Cell> traceNodes(NodeStore& nodes, int goal_idx, const GridGraph& graph)
+{
+    std::vector<Cell> path;
+    for (int cur = goal_idx; cur >= 0; cur = findNode(nodes, cur)->parent)
+    {
+        path.push_back(idxToCell(cur, graph));
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+
+std::vector<Cell> scratchBreadthFirstSearch(GridGraph& graph, const Cell& start, const Cell& goal)
+{
+    return scratchBreadthFirstSearch(graph, graph, start, goal);
+}
+
+
+std::vector<Cell> scratchBreadthFirstSearch(const GridGraph& graph, SearchScratch& scratch,
+                                            const Cell& start, const Cell& goal)
+{
+    initSearchScratch(graph, scratch);  // Make sure the visited cells are reset.
+
+    if (!isCellInBounds(start.i, start.j, graph) || !isCellInBounds(goal.i, goal.j, graph))
+    {
+        return std::vector<Cell>();
+    }
+
+    NodeStore nodes;
+    initNodeStore(nodes, graph, int64_t(graph.width) * graph.height, estimateSearchNodes(graph, start, goal));
+
+    int start_idx = cellToIdx(start.i, start.j, graph);
+    int goal_idx = cellToIdx(goal.i, goal.j, graph);
+    getNode(nodes, start_idx)->cost = 0;
+    std::queue<int> open;
+    open.push(start_idx);
+
+    bool found = start_idx == goal_idx;
+    int expansions = 0;
+    while (!open.empty() && !found)
+    {
+        if (++expansions % SEARCH_CANCEL_INTERVAL == 0 && isSearchCancelled(scratch)) return std::vector<Cell>();
+
+        int idx = open.front();
+        open.pop();
+        float cost = findNode(nodes, idx)->cost;
+
+        Cell c = idxToCell(idx, graph);
+        recordVisited(c, graph, scratch);
+
+        for (int n = 0; n < 8 && !found; ++n)
+        {
+            int ni = c.i + STEP_DI[n], nj = c.j + STEP_DJ[n];
+            if (!isCellInBounds(ni, nj, graph)) continue;
+
+            int n_idx = cellToIdx(ni, nj, graph);
+            if (checkCollisionFast(n_idx, graph)) continue;
+
+            NodeRecord* neighbor = getNode(nodes, n_idx);
+            if (neighbor == nullptr)
+            {
+                std::cerr << "ERROR: scratchBreadthFirstSearch: Node memory cap of "
+                          << (nodes.memory_cap >> 20) << " MB reached." << std::endl;
+                scratch.search_status = SEARCH_MEMORY_CAP;
+                return std::vector<Cell>();
+            }
+            if (neighbor->cost < HIGH) continue;  // Already reached.
+
+            // Every step costs the same, so the first time a cell is reached
+            // is along a path with the fewest steps.
+            neighbor->cost = cost + 1;
+            neighbor->parent = idx;
+            found = n_idx == goal_idx;
+            open.push(n_idx);
+        }
+    }
+
+    if (!found) return std::vector<Cell>();
+    return traceNodes(nodes, goal_idx, graph);
+}
+
+
+std::vector<Cell> scratchAStarSearch(GridGraph& graph, const Cell& start, const Cell& goal)
+{
+    return scratchAStarSearch(graph, graph, start, goal);
+}
+
+
+std::vector<Cell> scratchAStarSearch(const GridGraph& graph, SearchScratch& scratch,
+                                     const Cell& start, const Cell& goal)
+{
+    initSearchScratch(graph, scratch);  // Make sure the visited cells are reset.
+
+    if (!isCellInBounds(start.i, start.j, graph) || !isCellInBounds(goal.i, goal.j, graph))
+    {
+        return std::vector<Cell>();
+    }
+
+    // Octile distance is the exact cost on an empty 8-connected grid.
+    auto heuristic = [&](int i, int j)
+    {
+        int di = std::abs(goal.i - i), dj = std::abs(goal.j - j);
+        return float(std::max(di, dj) + (M_SQRT2 - 1) * std::min(di, dj));
+    };
+
+    NodeStore nodes;
+    initNodeStore(nodes, graph, int64_t(graph.width) * graph.height, estimateSearchNodes(graph, start, goal));
+
+    typedef std::pair<float, int> QueueItem;  // Estimated total cost, index.
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem> > open;
+
+    int start_idx = cellToIdx(start.i, start.j, graph);
+    int goal_idx = cellToIdx(goal.i, goal.j, graph);
+    getNode(nodes, start_idx)->cost = 0;
+    open.push({heuristic(start.i, start.j), start_idx});
+
+    bool found = false;
+    int expansions = 0;
+    while (!open.empty())
+    {
+        if (++expansions % SEARCH_CANCEL_INTERVAL == 0 && isSearchCancelled(scratch)) return std::vector<Cell>();
+
+        int idx = open.top().second;
+        open.pop();
+
+        NodeRecord* node = findNode(nodes, idx);
+        if (node->closed) continue;  // Stale queue entry.
+        node->closed = true;
+        float cost = node->cost;
+
+        if (idx == goal_idx)
+        {
+            found = true;
+            break;
+        }
+
+        Cell c = idxToCell(idx, graph);
+        recordVisited(c, graph, scratch);
+
+        for (int n = 0; n < 8; ++n)
+        {
+            int ni = c.i + STEP_DI[n], nj = c.j + STEP_DJ[n];
+            if (!isCellInBounds(ni, nj, graph)) continue;
+
+            int n_idx = cellToIdx(ni, nj, graph);
+            if (checkCollisionFast(n_idx, graph)) continue;
+
+            NodeRecord* neighbor = getNode(nodes, n_idx);
+            if (neighbor == nullptr)
+            {
+                std::cerr << "ERROR: scratchAStarSearch: Node memory cap of "
+                          << (nodes.memory_cap >> 20) << " MB reached." << std::endl;
+                scratch.search_status = SEARCH_MEMORY_CAP;
+                return std::vector<Cell>();
+            }
+
+            float next_cost = cost + ((n < 4) ? 1 : M_SQRT2);
+            if (!neighbor->closed && next_cost < neighbor->cost)
+            {
+                neighbor->cost = next_cost;
+                neighbor->parent = idx;
+                open.push({next_cost + heuristic(ni, nj), n_idx});
+            }
+        }
+    }
+
+    if (!found) return std::vector<Cell>();
+    return traceNodes(nodes, goal_idx, graph);
+}
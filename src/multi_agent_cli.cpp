@@ -0,0 +1,174 @@
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/utils/query_trace.h>
+#include <path_planning/graph_search/multi_agent.h>
+#include <path_planning/graph_search/planner.h>
+
+
+/**
+ * @brief Print Usage prints the command line usage for the program
+ */
+void print_usage()
+{
+    std::cout << "Usage:\n";
+    std::cout << "./multi_agent_cli [map_file] [agents_file|random:N] [options]" << std::endl;
+    std::cout << "Plans paths for several robots at once, highest priority first.\n";
+    std::cout << "The agents file has one robot per line: start_i start_j goal_i goal_j.\n";
+    std::cout << "random:N places N robots on random free cells instead.\n";
+    std::cout << "Options:\n";
+    std::cout << "\t--budget=MS  Time budget for planning all the robots (default: 500).\n";
+    std::cout << "\t--separation=CELLS  Distance robots keep apart (default: twice the collision radius).\n";
+    std::cout << "\t--max-time=STEPS  Longest allowed path (default: twice the map width plus height).\n";
+    std::cout << "\t--seed=N  Seed for random robots (default: 0).\n";
+}
+
+
+/**
+ * Reads the robots from a file with one "start_i start_j goal_i goal_j" line per robot.
+ */
+static bool readAgents(const std::string& file_path, std::vector<AgentQuery>& agents)
+{
+    std::ifstream in(file_path);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::stringstream ss(line);
+        AgentQuery agent;
+        if (ss >> agent.start.i >> agent.start.j >> agent.goal.i >> agent.goal.j) agents.push_back(agent);
+    }
+    return true;
+}
+
+
+/**
+ * Picks num_agents starts and goals on free cells. Starts are kept further
+ * than the separation from each other, and so are goals.
+ */
+static void randomAgents(const GridGraph& graph, int num_agents, int separation, unsigned int seed,
+                         std::vector<AgentQuery>& agents)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pick_i(0, graph.width - 1), pick_j(0, graph.height - 1);
+
+    auto isSpread = [&](const Cell& c, bool start)
+    {
+        for (auto& other : agents)
+        {
+            const Cell& o = start ? other.start : other.goal;
+            int di = c.i - o.i, dj = c.j - o.j;
+            if (di * di + dj * dj <= separation * separation) return false;
+        }
+        return true;
+    };
+    auto pickCell = [&](bool start)
+    {
+        for (int attempt = 0; attempt < 100000; ++attempt)
+        {
+            Cell c = {pick_i(rng), pick_j(rng)};
+            if (!checkCollisionFast(cellToIdx(c.i, c.j, graph), graph) && isSpread(c, start)) return c;
+        }
+        return Cell{-1, -1};
+    };
+
+    for (int a = 0; a < num_agents; ++a)
+    {
+        AgentQuery agent = {pickCell(true), pickCell(false)};
+        if (agent.start.i < 0 || agent.goal.i < 0) break;
+        agents.push_back(agent);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        print_usage();
+        return -1;
+    }
+
+    std::string map_file(argv[1]), agents_spec(argv[2]);
+    MultiAgentOptions options;
+    unsigned int seed = 0;
+    for (int k = 3; k < argc; ++k)
+    {
+        std::string arg(argv[k]);
+        if (arg.find("--budget=") == 0)
+        {
+            options.time_budget_ms = std::atof(arg.substr(std::string("--budget=").size()).c_str());
+        }
+        else if (arg.find("--separation=") == 0)
+        {
+            options.separation = std::atoi(arg.substr(std::string("--separation=").size()).c_str());
+        }
+        else if (arg.find("--max-time=") == 0)
+        {
+            options.max_time = std::atoi(arg.substr(std::string("--max-time=").size()).c_str());
+        }
+        else if (arg.find("--seed=") == 0)
+        {
+            seed = std::atoi(arg.substr(std::string("--seed=").size()).c_str());
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            print_usage();
+            return -1;
+        }
+    }
+
+    GridGraph graph;
+    if (!loadFromFile(map_file, graph))
+    {
+        std::cerr << "Invalid map file: " << map_file << std::endl;
+        return -1;
+    }
+    computeDistanceTransform("int", graph);
+
+    std::vector<AgentQuery> agents;
+    if (agents_spec.find("random:") == 0)
+    {
+        int num_agents = std::atoi(agents_spec.substr(std::string("random:").size()).c_str());
+        int separation = options.separation >= 0 ? options.separation :
+                         static_cast<int>(std::ceil(2 * graph.collision_radius / graph.meters_per_cell));
+        randomAgents(graph, num_agents, separation, seed, agents);
+    }
+    else if (!readAgents(agents_spec, agents))
+    {
+        std::cerr << "Invalid agents file: " << agents_spec << std::endl;
+        return -1;
+    }
+
+    uint64_t plan_start = traceTimeMicro();
+    MultiAgentResult result = prioritizedPlan(graph, agents, options);
+    uint64_t plan_us = traceTimeMicro() - plan_start;
+
+    std::cout << std::setw(5) << "robot" << std::setw(14) << "start" << std::setw(14) << "goal"
+              << std::setw(8) << "steps" << "\n";
+    for (size_t a = 0; a < agents.size(); ++a)
+    {
+        const AgentQuery& agent = agents[a];
+        std::cout << std::setw(5) << a
+                  << std::setw(14) << ("(" + std::to_string(agent.start.i) + ", " + std::to_string(agent.start.j) + ")")
+                  << std::setw(14) << ("(" + std::to_string(agent.goal.i) + ", " + std::to_string(agent.goal.j) + ")")
+                  << std::setw(8) << (result.paths[a].empty() ? std::string("-") :
+                                      std::to_string(result.paths[a].size() - 1)) << "\n";
+    }
+
+    std::cout << "Planned " << result.num_planned << " of " << agents.size() << " robots in "
+              << plan_us / 1000.0 << " ms.\n";
+    if (result.over_budget) std::cout << "Planning stopped at the time budget.\n";
+    if (result.memory_capped) std::cout << "A robot's search stopped at the node memory cap.\n";
+
+    return 0;
+}
@@ -1,12 +1,18 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <cstdlib>
+#include <cmath>
 
 #include <path_planning/utils/math_helpers.h>
 #include <path_planning/utils/graph_utils.h>
 #include <path_planning/utils/viz_utils.h>
+#include <path_planning/utils/query_trace.h>
 #include <path_planning/graph_search/graph_search.h>
 #include <path_planning/graph_search/distance_transform.h>
+#include <path_planning/graph_search/roadmap.h>
+#include <path_planning/graph_search/planner.h>
 
 
 /**
@@ -15,12 +21,43 @@
 void print_usage()
 {
     std::cout << "Usage:\n";
-    std::cout << "./planner [map_file] [planning_algo] [start_x] [start_y] [goal_x] [goal_y]" << std::endl;
+    std::cout << "./planner [map_file] [planning_algo] [start_x] [start_y] [goal_x] [goal_y] [options]" << std::endl;
+    std::cout << "Options:\n";
+    std::cout << "\t--dt=[float|int]  Distance transform to use for checkCollisionFast (default: float).\n";
+    std::cout << "\t--footprint=L,W  Rectangular robot footprint in meters for the lattice planner.\n";
+    std::cout << "\t--clearance=[linear|exp]:R  Clearance cost decay and radius in meters for castar.\n";
+    std::cout << "\t--portfolio=A,B,...  Planners the portfolio planner runs at once, from bfs and astar (default: astar,bfs).\n";
+    std::cout << "\t--portfolio-stats=FILE  Keep portfolio wins per map in FILE, to start past winners first (default: not kept).\n";
+    std::cout << "\t--roadmap=FILE  Load the roadmap from FILE, or build it and save it there (default: next to the map).\n";
+    std::cout << "\t--nodes=[auto|dense|sparse]  How searches store node data (default: auto).\n";
+    std::cout << "\t--node-cap=MB  Memory cap for search node data, in megabytes.\n";
+    std::cout << "\t--trace=FILE  Append a record of this query to a binary trace file.\n";
+    std::cout << "\t--visited=[off|all|bitmap|nth:N|ring:N]  How to record visited cells (default: all).\n";
+}
+
+/**
+ * Reads a positive number which makes up the whole text.
+ * @return  False if the text is not a number or the number is not positive.
+ */
+static bool parsePositive(const std::string& text, float& value)
+{
+    char* end = nullptr;
+    float parsed = std::strtof(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !(parsed > 0) || std::isinf(parsed)) return false;
+    value = parsed;
+    return true;
 }
 
 int main(int argv, char **argc)
 {
     std::string map_file, planning_algo;
+    std::string visited_policy = "all";
+    std::string dt_mode = "float";
+    std::string trace_file;
+    PlannerOptions options;
+    bool roadmap_set = false;
+    std::string node_storage = "auto";
+    int node_cap_mb = -1;
     Cell start, goal;
     if (argv >= 7)
     {
@@ -29,6 +66,80 @@ int main(int argv, char **argc)
         planning_algo = std::string(argc[2]);
         start = {std::atoi(argc[3]), std::atoi(argc[4])};
         goal = {std::atoi(argc[5]), std::atoi(argc[6])};
+
+        // Any remaining arguments are options of the form --name=value.
+        for (int k = 7; k < argv; ++k)
+        {
+            std::string arg(argc[k]);
+            if (arg.find("--visited=") == 0)
+            {
+                visited_policy = arg.substr(std::string("--visited=").size());
+            }
+            else if (arg.find("--dt=") == 0)
+            {
+                dt_mode = arg.substr(std::string("--dt=").size());
+            }
+            else if (arg.find("--footprint=") == 0)
+            {
+                std::string spec = arg.substr(std::string("--footprint=").size());
+                size_t comma = spec.find(',');
+                if (comma == std::string::npos || !parsePositive(spec.substr(0, comma), options.footprint_length) ||
+                    !parsePositive(spec.substr(comma + 1), options.footprint_width))
+                {
+                    std::cerr << "Invalid option: " << arg << std::endl;
+                    print_usage();
+                    exit(1);
+                }
+            }
+            else if (arg.find("--clearance=") == 0)
+            {
+                std::string spec = arg.substr(std::string("--clearance=").size());
+                std::string decay = spec.substr(0, spec.find(':'));
+                if (decay == "linear") options.clearance.decay = CLEARANCE_LINEAR;
+                else if (decay == "exp") options.clearance.decay = CLEARANCE_EXPONENTIAL;
+                if ((decay != "linear" && decay != "exp") || (spec.find(':') != std::string::npos &&
+                    !parsePositive(spec.substr(spec.find(':') + 1), options.clearance.influence_radius)))
+                {
+                    std::cerr << "Invalid option: " << arg << std::endl;
+                    print_usage();
+                    exit(1);
+                }
+            }
+            else if (arg.find("--portfolio=") == 0)
+            {
+                std::stringstream names(arg.substr(std::string("--portfolio=").size()));
+                std::string name;
+                options.portfolio.clear();
+                while (std::getline(names, name, ',')) options.portfolio.push_back(name);
+            }
+            else if (arg.find("--portfolio-stats=") == 0)
+            {
+                options.portfolio_stats = arg.substr(std::string("--portfolio-stats=").size());
+            }
+            else if (arg.find("--roadmap=") == 0)
+            {
+                options.roadmap_file = arg.substr(std::string("--roadmap=").size());
+                roadmap_set = true;
+            }
+            else if (arg.find("--nodes=") == 0)
+            {
+                node_storage = arg.substr(std::string("--nodes=").size());
+            }
+            else if (arg.find("--node-cap=") == 0)
+            {
+                node_cap_mb = std::atoi(arg.substr(std::string("--node-cap=").size()).c_str());
+            }
+            else if (arg.find("--trace=") == 0)
+            {
+                trace_file = arg.substr(std::string("--trace=").size());
+            }
+            else
+            {
+                std::cerr << "Invalid option: " << arg << std::endl;
+                print_usage();
+                exit(1);
+            }
+        }
     }
     else
     {
@@ -46,43 +157,84 @@ int main(int argv, char **argc)
         std::cin >> goal.i;
         std::cout << "\tj: ";
         std::cin >> goal.j;
-        std::cout << "Which algorithm would you like to use? [dfs, bfs, astar] : ";
+        std::cout << "Which algorithm would you like to use? [dfs, bfs, astar, c2f, lattice, castar, roadmap, portfolio] : ";
         std::cin >> planning_algo;
     }
 
+    // The roadmap is saved next to the map unless another file was given.
+    if (!roadmap_set) options.roadmap_file = roadmapFilePath(map_file);
+
+    if (!isValidPlanner(planning_algo))
+    {
+        std::cerr << "Invalid planning algorithm: " << planning_algo << std::endl;
+        exit(1);
+    }
+
     // Load the graph and make sure that it is loaded successfully.
+    uint64_t start_time = traceTimeMicro();
     GridGraph graph;
     if (!loadFromFile(map_file, graph))
     {
         std::cerr << "Invalid map file: " << map_file << std::endl;
         exit(1);
     }
+    uint64_t load_time = traceTimeMicro();
+
+    if (!setVisitedPolicy(visited_policy, graph))
+    {
+        print_usage();
+        exit(1);
+    }
+
+    if (node_storage == "dense") graph.node_storage = NODES_DENSE;
+    else if (node_storage == "sparse") graph.node_storage = NODES_SPARSE;
+    else if (node_storage != "auto")
+    {
+        std::cerr << "Invalid node storage: " << node_storage << std::endl;
+        exit(1);
+    }
+    if (node_cap_mb > 0) graph.node_memory_cap = size_t(node_cap_mb) << 20;
 
     // Perform the distance transform (optional: to use checkCollisionFast).
-    distanceTransformEuclidean2D(graph);
+    if (!computeDistanceTransform(dt_mode, graph))
+    {
+        print_usage();
+        exit(1);
+    }
+    // Build what the planner keeps per map, so the search time is only the search.
+    buildPlannerCaches(planning_algo, graph, options);
+    uint64_t dt_time = traceTimeMicro();
 
     // Plan a path using the requested algorithm.
-    std::vector<Cell> path;
-    if (planning_algo == "astar")
+    PlanSummary summary;
+    std::vector<Cell> path = planPath(planning_algo, graph, start, goal, options, &summary);
+    uint64_t search_time = traceTimeMicro();
+
+    std::cout << "Found path of length: " << path.size() << "\n";
+    if (planning_algo == "castar" && path.size() > 0)
     {
-        path = aStarSearch(graph, start, goal);
+        std::cout << "Clearance cost: " << summary.clearance_cost << "\n";
     }
-    else if (planning_algo == "bfs")
+    if (summary.winner.size() > 0)
     {
-        path = breadthFirstSearch(graph, start, goal);
+        std::cout << "Portfolio winner: " << summary.winner << " after " << summary.winner_us / 1000.0 << " ms\n";
     }
-    else if (planning_algo == "dfs")
+    if (graph.search_status == SEARCH_MEMORY_CAP)
     {
-        path = depthFirstSearch(graph, start, goal);
+        std::cout << "The search stopped at the node memory cap. Raise it with --node-cap.\n";
     }
-    else
+
+    if (trace_file.size() > 0)
     {
-        std::cerr << "Invalid planning algorithm: " << std::endl;
-        exit(1);
+        QueryRecord record = makeQueryRecord(graph, start, goal, planning_algo, dt_mode, path);
+        recordPlannerOptions(options, record);
+        record.load_us = load_time - start_time;
+        record.dt_us = dt_time - load_time;
+        record.search_us = search_time - dt_time;
+        record.total_us = search_time - start_time;
+        appendQueryRecord(trace_file, record);
     }
 
-    std::cout << "Found path of length: " << path.size() << "\n";
-
     // Generate the planning file for visualization in the nav app.
     generatePlanFile(start, goal, path, graph, planning_algo);
 
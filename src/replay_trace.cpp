@@ -0,0 +1,125 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/utils/query_trace.h>
+#include <path_planning/graph_search/planner.h>
+
+
+/**
+ * @brief Print Usage prints the command line usage for the program
+ */
+void print_usage()
+{
+    std::cout << "Usage:\n";
+    std::cout << "./replay_trace [trace_file] [map_file] [planning_algo (optional)]" << std::endl;
+    std::cout << "Re-runs every query in the trace on the map and compares the search times.\n";
+    std::cout << "If a planning algorithm is given, it is used instead of the recorded one.\n";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        print_usage();
+        return -1;
+    }
+
+    std::string trace_file(argv[1]), map_file(argv[2]);
+    std::string algo_override = argc > 3 ? std::string(argv[3]) : "";
+    if (algo_override.size() > 0 && !isValidPlanner(algo_override))
+    {
+        std::cerr << "Invalid planning algorithm: " << algo_override << std::endl;
+        return -1;
+    }
+
+    std::vector<QueryRecord> records;
+    if (!readQueryTrace(trace_file, records)) return -1;
+
+    GridGraph graph;
+    if (!loadFromFile(map_file, graph))
+    {
+        std::cerr << "Invalid map file: " << map_file << std::endl;
+        return -1;
+    }
+    setVisitedPolicy("off", graph);
+    uint64_t map_hash = hashMap(graph);
+
+    std::cout << "Replaying " << records.size() << " queries from " << trace_file << "\n";
+    std::cout << std::setw(5) << "query" << std::setw(10) << "algo"
+              << std::setw(12) << "trace_us" << std::setw(12) << "replay_us"
+              << std::setw(10) << "ratio" << std::setw(12) << "trace_len" << std::setw(12) << "replay_len"
+              << std::setw(12) << "trace_exp" << std::setw(12) << "replay_exp" << "\n";
+
+    // The distance transform only depends on the map, so it is only rerun
+    // when the mode changes.
+    std::string dt_mode;
+    uint64_t total_trace_us = 0, total_replay_us = 0;
+    int mismatched_maps = 0, changed_paths = 0;
+    for (size_t q = 0; q < records.size(); ++q)
+    {
+        const QueryRecord& record = records[q];
+        if (record.map_hash != map_hash) mismatched_maps++;
+
+        if (dt_mode != record.dt_mode)
+        {
+            dt_mode = record.dt_mode;
+            if (!computeDistanceTransform(dt_mode, graph)) return -1;
+        }
+        graph.collision_radius = record.collision_radius;
+        updateCollisionThreshold(graph);
+
+        std::string algo = algo_override.size() > 0 ? algo_override : std::string(record.algo);
+        if (!isValidPlanner(algo))
+        {
+            std::cerr << "Skipping query " << q << " with unknown algorithm " << algo << std::endl;
+            continue;
+        }
+
+        PlannerOptions options;
+        if (!restorePlannerOptions(record, algo, options))
+        {
+            std::cerr << "Skipping query " << q << " since its " << algo
+                      << " options were not recorded" << std::endl;
+            continue;
+        }
+        options.portfolio_stats = "";  // Replaying should not change the learned win counts.
+
+        Cell start = {record.start_i, record.start_j};
+        Cell goal = {record.goal_i, record.goal_j};
+
+        // Per map data, like the roadmap, is built once and not timed, as when
+        // the query was recorded.
+        buildPlannerCaches(algo, graph, options);
+
+        uint64_t search_start = traceTimeMicro();
+        std::vector<Cell> path = planPath(algo, graph, start, goal, options);
+        uint64_t replay_us = traceTimeMicro() - search_start;
+
+        if (path.size() != record.path_length) changed_paths++;
+        total_trace_us += record.search_us;
+        total_replay_us += replay_us;
+
+        float ratio = record.search_us > 0 ? float(replay_us) / record.search_us : 0;
+        std::cout << std::setw(5) << q << std::setw(10) << algo
+                  << std::setw(12) << record.search_us << std::setw(12) << replay_us
+                  << std::setw(10) << std::setprecision(3) << ratio
+                  << std::setw(12) << record.path_length << std::setw(12) << path.size()
+                  << std::setw(12) << record.expansions << std::setw(12) << graph.visited_count << "\n";
+    }
+
+    std::cout << "Total search time: " << total_trace_us << " us recorded, "
+              << total_replay_us << " us replayed.\n";
+    if (mismatched_maps > 0)
+    {
+        std::cout << "WARNING: " << mismatched_maps << " queries were recorded on a different map.\n";
+    }
+    if (changed_paths > 0)
+    {
+        std::cout << "WARNING: " << changed_paths << " queries found a path of a different length.\n";
+    }
+
+    return 0;
+}
@@ -1,14 +1,111 @@
 #include <iostream>
 #include <cmath>
 #include <string>
+#include <future>
+#include <thread>
+#include <algorithm>
 
+#ifdef MOCK_MBOT
+#include <path_planning/utils/mock_mbot.h>
+#else
 #include <mbot_bridge/robot.h>
+#endif
 
 #include <path_planning/utils/graph_utils.h>
 #include <path_planning/utils/math_helpers.h>
 #include <path_planning/utils/viz_utils.h>
+#include <path_planning/utils/query_trace.h>
 #include <path_planning/graph_search/graph_search.h>
 #include <path_planning/graph_search/distance_transform.h>
+#include <path_planning/graph_search/lattice_planner.h>
+#include <path_planning/graph_search/scratch_search.h>
+#include <path_planning/graph_search/roadmap.h>
+#include <path_planning/graph_search/planner.h>
+
+#define PREFIX_LENGTH 0.5  // Length of path in meters to verify and send to the robot while the planner runs.
+
+
+/**
+ * Checks the path for collisions. The distance transform check is used if a
+ * distance transform was computed. The start is not checked, since the robot
+ * is already there, even if it is close to a wall.
+ * @param  first  The first cell to check. Cells before it are the start and
+ *                the robot's way out of the collision radius.
+ * @return  The index of the first cell in collision, or the path length if
+ *          there is none.
+ */
+static size_t verifyPath(const std::vector<Cell>& path, const GridGraph& graph, bool use_dt, size_t first = 1)
+{
+    for (size_t k = first; k < path.size(); ++k)
+    {
+        int idx = cellToIdx(path[k].i, path[k].j, graph);
+        if (use_dt ? checkCollisionFast(idx, graph) : checkCollision(idx, graph)) return k;
+    }
+    return path.size();
+}
+
+
+/**
+ * Finds a way out of the collision radius for a robot which starts inside it,
+ * by stepping to the neighbor furthest from obstacles until the robot is
+ * clear. The searches can't leave a start with no clear neighbors.
+ * @return  The cells from the start to the first clear cell, or just the start
+ *          if it is clear or there is no distance transform. Empty if the
+ *          robot is stuck.
+ */
+static std::vector<Cell> escapeCollision(const Cell& start, const GridGraph& graph)
+{
+    std::vector<Cell> path = {start};
+    auto distance = [&](int idx)
+    {
+        return graph.obstacle_sq_distances.empty() ? graph.obstacle_distances[idx]
+                                                   : float(graph.obstacle_sq_distances[idx]);
+    };
+    if (graph.obstacle_sq_distances.empty() && graph.obstacle_distances.empty()) return path;
+    if (!isCellInBounds(start.i, start.j, graph)) return path;
+
+    // Distances only go up, so this ends.
+    while (checkCollisionFast(cellToIdx(path.back().i, path.back().j, graph), graph))
+    {
+        Cell c = path.back();
+        Cell best = c;
+        float best_dist = distance(cellToIdx(c.i, c.j, graph));
+        for (int dj = -1; dj <= 1; ++dj)
+        {
+            for (int di = -1; di <= 1; ++di)
+            {
+                if (!isCellInBounds(c.i + di, c.j + dj, graph)) continue;
+                float dist = distance(cellToIdx(c.i + di, c.j + dj, graph));
+                if (dist > best_dist)
+                {
+                    best = {c.i + di, c.j + dj};
+                    best_dist = dist;
+                }
+            }
+        }
+        if (best.i == c.i && best.j == c.j) return std::vector<Cell>();
+        path.push_back(best);
+    }
+    return path;
+}
+
+
+/**
+ * Checks the footprint along a lattice path for collisions. The states at the
+ * start cell are not checked, since the robot is already there.
+ * @return  The index of the first state in collision, or the path length if
+ *          there is none.
+ */
+static size_t verifyLatticePath(const std::vector<LatticeState>& path, const GridGraph& graph,
+                                const Lattice& lattice)
+{
+    for (size_t k = 0; k < path.size(); ++k)
+    {
+        bool at_start = path[k].i == path[0].i && path[k].j == path[0].j;
+        if (!at_start && checkFootprintCollision(path[k], graph, lattice)) return k;
+    }
+    return path.size();
+}
 
 
 int main(int argc, char const *argv[])
@@ -21,25 +118,60 @@ int main(int argc, char const *argv[])
         return -1;
     }
 
-    if (argc == 4)
+    if (argc >= 4)
     {
         goal_x = std::stof(argv[2]);
         goal_y = std::stof(argv[3]);
     }
 
+    // An optional planner name (for example "portfolio") plans with planPath()
+    // on the integer distance transform instead of your own search.
+    std::string planner_name = argc >= 5 ? argv[4] : "";
+    if (planner_name.size() > 0 && !isValidPlanner(planner_name))
+    {
+        std::cerr << "Invalid planning algorithm: " << planner_name << std::endl;
+        return -1;
+    }
+
     std::string map_file = argv[1];
+    uint64_t start_time = traceTimeMicro();
+    uint64_t load_time = 0, dt_time = 0;
+    std::string dt_mode = "none";  // Set to "float" or "int" if you compute a distance transform.
+    if (planner_name.size() > 0) dt_mode = "int";
+
+    // Load the map and compute the distance transform in the background while
+    // waiting for the robot's pose. The planner's per map data is built there too.
     GridGraph graph;
-    loadFromFile(map_file, graph);
+    PlannerOptions options;
+    options.roadmap_file = roadmapFilePath(map_file);  // Saved next to the map.
+    std::future<bool> map_ready = std::async(std::launch::async, [&]()
+    {
+        if (!loadFromFile(map_file, graph)) return false;
+        load_time = traceTimeMicro();
 
-    // TODO: Call your distance transform function if using checkCollisionFast().
-    // HINT: You may want to set a new value for graph.collision_radius.
+        // Record visited cells as a bitmap. This keeps the visualization without
+        // letting the visited list grow with every expansion on large maps.
+        setVisitedPolicy("bitmap", graph);
 
-    Cell goal = posToCell(goal_x, goal_y, graph);
+        // TODO: Call your distance transform function if using checkCollisionFast().
+        // Alternatively, distanceTransformSquared() computes an exact integer distance transform.
+        // HINT: You may want to set a new value for graph.collision_radius.
+        computeDistanceTransform(dt_mode, graph);
+        if (planner_name.size() > 0) buildPlannerCaches(planner_name, graph, options);
+        dt_time = traceTimeMicro();
+        return true;
+    });
 
     // Initialize the robot.
     mbot_bridge::MBot robot;
     // Get the robot's SLAM pose.
     std::vector<float> pose = robot.readSlamPose();
+
+    if (!map_ready.get())
+    {
+        std::cerr << "Failed to load map " << map_file << std::endl;
+        return -1;
+    }
     if (pose.size() == 0)
     {
         std::cerr << "No pose information! Can't plan." << std::endl;
@@ -47,14 +179,126 @@ int main(int argc, char const *argv[])
     }
 
     Cell start = posToCell(pose[0], pose[1], graph);
+    Cell goal = posToCell(goal_x, goal_y, graph);
 
     std::vector<Cell> path;
-    // TODO: Call graph search function and put the result in path.
+    std::vector<LatticeState> lattice_path;  // The states of a lattice plan, with the heading at each.
+    Lattice lattice;
+    std::string planning_algo = "none";  // Set to the name of the search you call below, for the trace.
+    Cell query_start = start;            // Where the search started, for the trace.
+    std::vector<Cell> planned;           // The path the search found from there, for the trace.
+    size_t escape_end = 1;               // Number of path cells before the robot leaves the collision radius.
+    bool use_dt = dt_mode != "none";
+    uint64_t search_start_time = traceTimeMicro();
+    if (planner_name == "lattice")
+    {
+        // Search the lattice directly rather than through planPath(), so the
+        // robot drives the planned headings. The start faces along x, as in
+        // planPath(), so the query replays the same.
+        planning_algo = planner_name;
+        initLattice(graph, makeRectangleFootprint(options.footprint_length, options.footprint_width), lattice);
+        lattice_path = latticeSearch(graph, lattice, {start.i, start.j, 0}, goal);
+        path = latticePathToCells(lattice_path);
+        planned = path;
+    }
+    else if (planner_name.size() > 0)
+    {
+        // Get the robot moving before the planner is done. A robot inside the
+        // collision radius first backs away from the wall. Then a quick A-star
+        // gives the next PREFIX_LENGTH meters, which are verified and sent to
+        // the robot while the planner plans the rest from the end of them.
+        planning_algo = planner_name;
+        std::vector<Cell> prefix = escapeCollision(start, graph);
+        if (prefix.empty())
+        {
+            std::cerr << "WARNING: The robot is inside the collision radius with no way out." << std::endl;
+            prefix.push_back(start);
+        }
+        escape_end = prefix.size();
 
-    robot.drivePath(cellsToPoses(path, graph));
+        SearchScratch lead_scratch;
+        lead_scratch.visited_policy = VISITED_OFF;
+        std::vector<Cell> lead = scratchAStarSearch(graph, lead_scratch, prefix.back(), goal);
+        lead.resize(std::min<size_t>(lead.size(), std::ceil(PREFIX_LENGTH / graph.meters_per_cell) + 1));
+        lead.resize(verifyPath(lead, graph, use_dt));
+        if (lead.size() > 1) prefix.insert(prefix.end(), lead.begin() + 1, lead.end());
+        if (prefix.size() > 1) query_start = prefix.back();
+
+        search_start_time = traceTimeMicro();
+        std::future<std::vector<Cell> > rest_ready = std::async(std::launch::async, [&]()
+        {
+            return planPath(planning_algo, graph, query_start, goal, options);
+        });
+        if (prefix.size() > 1) robot.drivePath(cellsToPoses(prefix, graph));
+        planned = rest_ready.get();
+
+        // Drive the prefix and then the planned path. If there is no planned
+        // path, the robot stops at the end of the prefix.
+        if (prefix.size() > 1 && planned.empty())
+        {
+            std::cerr << "WARNING: " << planning_algo << " found no path from the end of the first ";
+            std::cerr << PREFIX_LENGTH << " m. Only driving those." << std::endl;
+            path = prefix;
+        }
+        else if (planned.size() > 0)
+        {
+            path.assign(prefix.begin(), prefix.end() - std::min<size_t>(prefix.size(), 1));
+            path.insert(path.end(), planned.begin(), planned.end());
+        }
+    }
+    else
+    {
+        // TODO: Call graph search function and put the result in path.
+        planned = path;
+    }
+    uint64_t search_time = traceTimeMicro();
+
+    // Record the query so slow plans can be replayed offline with replay_trace.
+    // There is nothing to replay if no search ran.
+    if (planning_algo != "none")
+    {
+        QueryRecord record = makeQueryRecord(graph, query_start, goal, planning_algo, dt_mode, planned);
+        recordPlannerOptions(options, record);
+        record.load_us = load_time - start_time;
+        record.dt_us = dt_time - load_time;
+        record.search_us = search_time - search_start_time;
+        record.total_us = search_time - start_time;
+        appendQueryRecord("robot_plan_path.trace", record);
+    }
+
+    // Save the path output file for visualization in the nav app while the
+    // robot drives. Nothing writes to the graph after this point.
+    std::thread plan_file_thread([start, goal, path, &graph]()
+    {
+        generatePlanFile(start, goal, path, graph);
+    });
+
+    // Make sure the path is collision free before driving it. Lattice paths
+    // are checked with the footprint they were planned with.
+    if (lattice_path.size() > 0)
+    {
+        size_t verified = verifyLatticePath(lattice_path, graph, lattice);
+        if (verified < lattice_path.size())
+        {
+            std::cerr << "WARNING: Lattice path state " << verified << " is in collision. ";
+            std::cerr << "Only driving the path before it." << std::endl;
+            lattice_path.resize(verified);
+        }
+        robot.drivePath(latticePathToPoses(lattice_path, lattice, graph));
+    }
+    else
+    {
+        size_t verified = verifyPath(path, graph, use_dt, escape_end);
+        if (verified < path.size())
+        {
+            std::cerr << "WARNING: Path cell " << verified << " is in collision. ";
+            std::cerr << "Only driving the path before it." << std::endl;
+            path.resize(verified);
+        }
+        robot.drivePath(cellsToPoses(path, graph));
+    }
 
-    // Save the path output file for visualization in the nav app.
-    generatePlanFile(start, goal, path, graph);
+    plan_file_thread.join();
 
     return 0;
 }
@@ -0,0 +1,200 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <path_planning/utils/graph_utils.h>
+#include <path_planning/utils/query_trace.h>
+
+
+static const char TRACE_MAGIC[8] = {'P', 'P', 'T', 'R', 'A', 'C', 'E', '2'};
+
+
+/**
+ * Writes or reads a plain value in the machine's byte order.
+ */
+template <class T>
+static inline void writeField(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+static inline void readField(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+
+/**
+ * Adds bytes to a 64 bit FNV-1a hash.
+ */
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t k = 0; k < size; ++k)
+    {
+        hash ^= bytes[k];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+uint64_t hashMap(const GridGraph& graph)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    hash = hashBytes(hash, &graph.width, sizeof(graph.width));
+    hash = hashBytes(hash, &graph.height, sizeof(graph.height));
+    hash = hashBytes(hash, &graph.origin_x, sizeof(graph.origin_x));
+    hash = hashBytes(hash, &graph.origin_y, sizeof(graph.origin_y));
+    hash = hashBytes(hash, &graph.meters_per_cell, sizeof(graph.meters_per_cell));
+    hash = hashBytes(hash, graph.cell_odds.data(), graph.cell_odds.size());
+    return hash;
+}
+
+
+uint64_t hashDistanceTransform(const GridGraph& graph)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    hash = hashBytes(hash, graph.obstacle_sq_distances.data(),
+                     graph.obstacle_sq_distances.size() * sizeof(graph.obstacle_sq_distances[0]));
+    hash = hashBytes(hash, graph.obstacle_distances.data(),
+                     graph.obstacle_distances.size() * sizeof(graph.obstacle_distances[0]));
+    return hash;
+}
+
+
+QueryRecord makeQueryRecord(const GridGraph& graph, const Cell& start, const Cell& goal,
+                            const std::string& algo, const std::string& dt_mode,
+                            const std::vector<Cell>& path)
+{
+    QueryRecord record;
+    std::memset(&record, 0, sizeof(record));
+
+    record.map_hash = hashMap(graph);
+    record.start_i = start.i;
+    record.start_j = start.j;
+    record.goal_i = goal.i;
+    record.goal_j = goal.j;
+    std::strncpy(record.algo, algo.c_str(), sizeof(record.algo) - 1);
+    std::strncpy(record.dt_mode, dt_mode.c_str(), sizeof(record.dt_mode) - 1);
+    record.collision_radius = graph.collision_radius;
+    record.path_length = path.size();
+    record.expansions = graph.visited_count;
+
+    return record;
+}
+
+
+bool appendQueryRecord(const std::string& trace_file, const QueryRecord& record)
+{
+    std::ofstream out(trace_file, std::ios::binary | std::ios::app);
+    if (!out.is_open())
+    {
+        std::cerr << "ERROR: appendQueryRecord: Failed to open " << trace_file << std::endl;
+        return false;
+    }
+
+    // New files start with the header. Records can't be added to files in
+    // another format.
+    out.seekp(0, std::ios::end);
+    if (out.tellp() == 0)
+    {
+        out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    }
+    else
+    {
+        char magic[sizeof(TRACE_MAGIC)];
+        std::ifstream in(trace_file, std::ios::binary);
+        in.read(magic, sizeof(magic));
+        if (!in || std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0)
+        {
+            std::cerr << "ERROR: appendQueryRecord: " << trace_file
+                      << " is not a trace file in the current format." << std::endl;
+            return false;
+        }
+    }
+
+    writeField(out, record.map_hash);
+    writeField(out, record.start_i);
+    writeField(out, record.start_j);
+    writeField(out, record.goal_i);
+    writeField(out, record.goal_j);
+    writeField(out, record.algo);
+    writeField(out, record.dt_mode);
+    writeField(out, record.collision_radius);
+    writeField(out, record.path_length);
+    writeField(out, record.expansions);
+    writeField(out, record.load_us);
+    writeField(out, record.dt_us);
+    writeField(out, record.search_us);
+    writeField(out, record.total_us);
+    writeField(out, record.has_options);
+    writeField(out, record.footprint_length);
+    writeField(out, record.footprint_width);
+    writeField(out, record.clearance_decay);
+    writeField(out, record.clearance_radius);
+    writeField(out, record.clearance_decay_length);
+    writeField(out, record.clearance_weight);
+    writeField(out, record.portfolio);
+
+    return out.good();
+}
+
+
+bool readQueryTrace(const std::string& trace_file, std::vector<QueryRecord>& records)
+{
+    std::ifstream in(trace_file, std::ios::binary);
+    if (!in.is_open())
+    {
+        std::cerr << "ERROR: readQueryTrace: Failed to open " << trace_file << std::endl;
+        return false;
+    }
+
+    char magic[sizeof(TRACE_MAGIC)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0)
+    {
+        std::cerr << "ERROR: readQueryTrace: Not a trace file: " << trace_file << std::endl;
+        return false;
+    }
+
+    records.clear();
+    while (true)
+    {
+        QueryRecord record;
+        std::memset(&record, 0, sizeof(record));
+        readField(in, record.map_hash);
+        readField(in, record.start_i);
+        readField(in, record.start_j);
+        readField(in, record.goal_i);
+        readField(in, record.goal_j);
+        readField(in, record.algo);
+        readField(in, record.dt_mode);
+        readField(in, record.collision_radius);
+        readField(in, record.path_length);
+        readField(in, record.expansions);
+        readField(in, record.load_us);
+        readField(in, record.dt_us);
+        readField(in, record.search_us);
+        readField(in, record.total_us);
+        readField(in, record.has_options);
+        readField(in, record.footprint_length);
+        readField(in, record.footprint_width);
+        readField(in, record.clearance_decay);
+        readField(in, record.clearance_radius);
+        readField(in, record.clearance_decay_length);
+        readField(in, record.clearance_weight);
+        readField(in, record.portfolio);
+
+        // A partial record at the end means the writer was interrupted.
+        if (!in) break;
+
+        record.algo[sizeof(record.algo) - 1] = '\0';
+        record.dt_mode[sizeof(record.dt_mode) - 1] = '\0';
+        record.portfolio[sizeof(record.portfolio) - 1] = '\0';
+        records.push_back(record);
+    }
+
+    return true;
+}